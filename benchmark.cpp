@@ -0,0 +1,806 @@
+// Microbenchmarks of Vector against std::vector.
+// Build: g++ -std=c++17 -O2 benchmark.cpp -o benchmark
+// Usage: benchmark [--max-size=N] [--filter=SUBSTRING] [--min-time-ms=MS]
+// Every line reports the time per item, the heap allocations per run and the peak RSS during the case.
+
+#include "vector.h"
+#include "small_vector.h"
+#include "static_vector.h"
+#include "thread_cache.h"
+#include "vector_algorithms.h"
+#include "concurrent_vector.h"
+#include "cow_vector.h"
+#include "flat_map.h"
+#include "segmented_vector.h"
+#include "soa_vector.h"
+#include "incremental_vector.h"
+#include "ring_vector.h"
+#include "mmap_allocator.h"
+#include "obj.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace {
+
+    size_t num_allocations = 0;
+
+}  // namespace
+
+// the replaced operator new allocates with malloc, so free is the matching function
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    ++num_allocations;
+    if (void* ptr = std::malloc(size != 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+    struct Pod64 {
+        int64_t values[8];
+    };
+
+    // keeps the compiler from throwing away the measured work
+    template <typename T>
+    void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    template <typename T>
+    T MakeValue(size_t i);
+
+    template <>
+    int MakeValue<int>(size_t i) {
+        return static_cast<int>(i);
+    }
+
+    template <>
+    Pod64 MakeValue<Pod64>(size_t i) {
+        Pod64 pod{};
+        pod.values[0] = static_cast<int64_t>(i);
+        return pod;
+    }
+
+    template <>
+    std::string MakeValue<std::string>(size_t i) {
+        // longer than the small string buffer
+        return "benchmark item number " + std::to_string(i);
+    }
+
+    template <>
+    Obj MakeValue<Obj>(size_t i) {
+        return Obj(static_cast<int>(i));
+    }
+
+    // the same operations spelled for both containers
+
+    template <typename T>
+    void PushBack(std::vector<T>& v, const T& value) {
+        v.push_back(value);
+    }
+
+    template <typename T, typename... Params>
+    void PushBack(Vector<T, Params...>& v, const T& value) {
+        v.PushBack(value);
+    }
+
+    template <typename T, size_t N>
+    void PushBack(StaticVector<T, N>& v, const T& value) {
+        v.PushBack(value);
+    }
+
+    template <typename T, typename Allocator, size_t FIRST_BLOCK_SIZE>
+    void PushBack(SegmentedVector<T, Allocator, FIRST_BLOCK_SIZE>& v, const T& value) {
+        v.PushBack(value);
+    }
+
+    template <typename T, typename Allocator, typename GrowthPolicy, size_t MIGRATION_STEP>
+    void PushBack(IncrementalVector<T, Allocator, GrowthPolicy, MIGRATION_STEP>& v, const T& value) {
+        v.PushBack(value);
+    }
+
+    template <typename T>
+    void EmplaceBack(std::vector<T>& v, T&& value) {
+        v.emplace_back(std::move(value));
+    }
+
+    template <typename T, typename... Params>
+    void EmplaceBack(Vector<T, Params...>& v, T&& value) {
+        [[maybe_unused]] T& res = v.EmplaceBack(std::move(value));
+    }
+
+    template <typename T>
+    void Reserve(std::vector<T>& v, size_t capacity) {
+        v.reserve(capacity);
+    }
+
+    template <typename T, typename... Params>
+    void Reserve(Vector<T, Params...>& v, size_t capacity) {
+        v.Reserve(capacity);
+    }
+
+    template <typename T>
+    void Insert(std::vector<T>& v, size_t index, const T& value) {
+        v.insert(v.begin() + index, value);
+    }
+
+    template <typename T, typename... Params>
+    void Insert(Vector<T, Params...>& v, size_t index, const T& value) {
+        [[maybe_unused]] auto res = v.Insert(v.cbegin() + index, value);
+    }
+
+    template <typename T>
+    void Erase(std::vector<T>& v, size_t index) {
+        v.erase(v.begin() + index);
+    }
+
+    template <typename T, typename... Params>
+    void Erase(Vector<T, Params...>& v, size_t index) {
+        [[maybe_unused]] auto res = v.Erase(v.cbegin() + index);
+    }
+
+    template <typename T>
+    size_t Size(const std::vector<T>& v) {
+        return v.size();
+    }
+
+    template <typename T, typename... Params>
+    size_t Size(const Vector<T, Params...>& v) {
+        return v.Size();
+    }
+
+    template <typename Container, typename T>
+    Container MakeContainer(size_t size) {
+        Container v;
+        Reserve(v, size);
+        for (size_t i = 0; i < size; ++i) {
+            PushBack(v, MakeValue<T>(i));
+        }
+        return v;
+    }
+
+    enum class Position {
+        FRONT,
+        MIDDLE,
+        BACK,
+    };
+
+    size_t GetIndex(Position position, size_t size) {
+        switch (position) {
+        case Position::FRONT:
+            return 0;
+        case Position::MIDDLE:
+            return size / 2;
+        case Position::BACK:
+            return size;
+        }
+        return size;
+    }
+
+    // VmHWM is reset by writing 5 to clear_refs, otherwise the peak of the whole process is reported
+    void ResetPeakRss() {
+        std::ofstream("/proc/self/clear_refs") << "5";
+    }
+
+    long GetPeakRssKb() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmHWM:", 0) == 0) {
+                return std::stol(line.substr(6));
+            }
+        }
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    struct Options {
+        size_t max_size = 1'000'000;
+        // operations that are quadratic in the size are not measured beyond this
+        size_t max_quadratic_size = 100'000;
+        std::string filter;
+        std::chrono::milliseconds min_time{ 100 };
+    };
+
+    Options options;
+
+    struct Measurement {
+        double ns_per_item = 0;
+        double allocations_per_run = 0;
+        long peak_rss_kb = 0;
+    };
+
+    // repeats run(), which processes items_per_run items, until it took at least the minimal time;
+    // setup() prepares the state for a run outside of the measured time, cases with an expensive setup
+    // stop earlier as the whole case is limited to ten minimal times
+    template <typename Setup, typename Run>
+    Measurement Measure(size_t items_per_run, Setup setup, Run run) {
+        using Clock = std::chrono::steady_clock;
+        ResetPeakRss();
+        const auto deadline = Clock::now() + options.min_time * 10;
+        Clock::duration total{};
+        size_t allocations = 0;
+        size_t runs = 0;
+        while (runs == 0 || (total < options.min_time && Clock::now() < deadline)) {
+            auto state = setup();
+            const size_t allocations_before = num_allocations;
+            const auto start = Clock::now();
+            run(state);
+            total += Clock::now() - start;
+            allocations += num_allocations - allocations_before;
+            ++runs;
+            DoNotOptimize(state);
+        }
+        const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(total).count());
+        return { ns / static_cast<double>(runs * std::max<size_t>(items_per_run, 1)),
+                 static_cast<double>(allocations) / static_cast<double>(runs), GetPeakRssKb() };
+    }
+
+    void Report(std::string_view name, std::string_view container, std::string_view type, size_t size,
+                const Measurement& measurement) {
+        std::printf("%-28.*s %-12.*s %-12.*s %10zu %12.2f %14.1f %12ld\n", static_cast<int>(name.size()), name.data(),
+                    static_cast<int>(container.size()), container.data(), static_cast<int>(type.size()), type.data(),
+                    size, measurement.ns_per_item, measurement.allocations_per_run, measurement.peak_rss_kb);
+        std::fflush(stdout);
+    }
+
+    struct NoState {
+    };
+
+    template <typename Container, typename T>
+    void RunCases(std::string_view container, std::string_view type, size_t size) {
+        auto report = [&](std::string_view name, const Measurement& measurement) {
+            if (name.find(options.filter) != std::string_view::npos) {
+                Report(name, container, type, size, measurement);
+            }
+        };
+        auto enabled = [&](std::string_view name) {
+            return name.find(options.filter) != std::string_view::npos;
+        };
+        auto no_setup = [] {
+            return NoState{};
+        };
+        auto make_full = [size] {
+            return MakeContainer<Container, T>(size);
+        };
+
+        if (enabled("PushBack")) {
+            report("PushBack", Measure(size, no_setup, [size](NoState&) {
+                Container v;
+                for (size_t i = 0; i < size; ++i) {
+                    PushBack(v, MakeValue<T>(i));
+                }
+                DoNotOptimize(v);
+            }));
+        }
+        if (enabled("EmplaceBack")) {
+            report("EmplaceBack", Measure(size, no_setup, [size](NoState&) {
+                Container v;
+                for (size_t i = 0; i < size; ++i) {
+                    EmplaceBack(v, MakeValue<T>(i));
+                }
+                DoNotOptimize(v);
+            }));
+        }
+        if (enabled("Reserve+PushBack")) {
+            report("Reserve+PushBack", Measure(size, no_setup, [size](NoState&) {
+                Container v;
+                Reserve(v, size);
+                for (size_t i = 0; i < size; ++i) {
+                    PushBack(v, MakeValue<T>(i));
+                }
+                DoNotOptimize(v);
+            }));
+        }
+        if (enabled("Reserve")) {
+            report("Reserve (relocation)", Measure(size, make_full, [size](Container& v) {
+                Reserve(v, size * 2);
+            }));
+        }
+
+        const std::pair<Position, std::string_view> positions[] = {
+            { Position::FRONT, "front" },
+            { Position::MIDDLE, "middle" },
+            { Position::BACK, "back" },
+        };
+        // each run inserts or erases min(size, 1000) items
+        const size_t num_changes = std::min<size_t>(size, 1'000);
+        for (const auto& [position, position_name] : positions) {
+            if (position != Position::BACK && size > options.max_quadratic_size) {
+                continue;
+            }
+            const std::string insert_name = "Insert " + std::string(position_name);
+            if (enabled(insert_name)) {
+                report(insert_name, Measure(num_changes, make_full, [position = position, num_changes](Container& v) {
+                    for (size_t i = 0; i < num_changes; ++i) {
+                        Insert(v, GetIndex(position, Size(v)), MakeValue<T>(i));
+                    }
+                }));
+            }
+            const std::string erase_name = "Erase " + std::string(position_name);
+            if (enabled(erase_name)) {
+                report(erase_name, Measure(num_changes, make_full, [position = position, num_changes](Container& v) {
+                    for (size_t i = 0; i < num_changes; ++i) {
+                        const size_t size = Size(v);
+                        Erase(v, std::min(GetIndex(position, size), size - 1));
+                    }
+                }));
+            }
+        }
+
+        // the three branches of copy assignment: a new buffer, a shorter and a longer destination
+        if (enabled("Assign")) {
+            const Container source = MakeContainer<Container, T>(size);
+            report("Assign (reallocation)", Measure(size, [] {
+                return Container{};
+            }, [&source](Container& v) {
+                v = source;
+            }));
+            report("Assign (grow in capacity)", Measure(size, [size] {
+                Container v = MakeContainer<Container, T>(size / 2);
+                Reserve(v, size);
+                return v;
+            }, [&source](Container& v) {
+                v = source;
+            }));
+            report("Assign (shrink)", Measure(size, [size] {
+                return MakeContainer<Container, T>(size * 2);
+            }, [&source](Container& v) {
+                v = source;
+            }));
+        }
+
+        if (enabled("Iterate")) {
+            const Container source = MakeContainer<Container, T>(size);
+            report("Iterate", Measure(size, no_setup, [&source](NoState&) {
+                size_t checksum = 0;
+                for (const T& item : source) {
+                    checksum += reinterpret_cast<const unsigned char&>(item);
+                }
+                DoNotOptimize(checksum);
+            }));
+        }
+    }
+
+    template <typename T>
+    void RunType(std::string_view type) {
+        for (size_t size = 1; size <= options.max_size; size *= 10) {
+            RunCases<std::vector<T>, T>("std::vector", type, size);
+            RunCases<Vector<T>, T>("Vector", type, size);
+        }
+    }
+
+    // many short-lived vectors that fit into the inline buffer of SmallVector
+    template <typename Container>
+    void RunShortVectors(std::string_view container) {
+        const std::string_view name = "Short vectors, 8 items";
+        if (name.find(options.filter) == std::string_view::npos) {
+            return;
+        }
+        const size_t num_vectors = 100'000;
+        const size_t num_items = 8;
+        Report(name, container, "int", num_items, Measure(num_vectors * num_items, [] {
+            return NoState{};
+        }, [](NoState&) {
+            for (size_t i = 0; i < num_vectors; ++i) {
+                Container v;
+                for (size_t j = 0; j < num_items; ++j) {
+                    PushBack(v, static_cast<int>(i + j));
+                }
+                DoNotOptimize(v);
+            }
+        }));
+    }
+
+    // the SIMD kernels of vector_algorithms.h at every level the CPU supports
+    template <typename T>
+    void RunBulkOperations(std::string_view type) {
+        const char* const level_names[] = { "scalar", "128 bit", "AVX2", "AVX-512" };
+        const size_t size = options.max_size;
+        auto report = [&](std::string_view name, SimdLevel level, auto run) {
+            if (name.find(options.filter) != std::string_view::npos) {
+                SetSimdLevel(level);
+                Report(name, level_names[static_cast<int>(level)], type, size, Measure(size, [] {
+                    return NoState{};
+                }, run));
+            }
+        };
+        Vector<T> v(size);
+        for (size_t i = 0; i < size; ++i) {
+            v[i] = static_cast<T>(i % 100);
+        }
+        const SimdLevel supported = GetSupportedSimdLevel();
+        for (int level_index = 0; level_index <= static_cast<int>(supported); ++level_index) {
+            const SimdLevel level = static_cast<SimdLevel>(level_index);
+            report("Bulk Fill", level, [&v](NoState&) {
+                Fill(v, T(1));
+                DoNotOptimize(v);
+            });
+            report("Bulk Find (missing)", level, [&v](NoState&) {
+                DoNotOptimize(Find(v, T(-1)));
+            });
+            report("Bulk Count", level, [&v](NoState&) {
+                DoNotOptimize(Count(v, T(1)));
+            });
+            report("Bulk Reduce (sum)", level, [&v](NoState&) {
+                DoNotOptimize(Reduce(v));
+            });
+            report("Bulk Reduce (min)", level, [&v](NoState&) {
+                DoNotOptimize(Reduce(v, T(0), Minimum{}));
+            });
+            report("Bulk Transform", level, [&v](NoState&) {
+                Transform(v, [](T x) {
+                    return T(3) - x;
+                });
+                DoNotOptimize(v);
+            });
+        }
+        SetSimdLevel(supported);
+    }
+
+    // the items of big vectors built and destroyed by one thread and by the threads of vector_parallel.h
+    template <typename T>
+    void RunParallelCases(std::string_view type) {
+        const size_t size = options.max_size;
+        for (bool parallel : { false, true }) {
+            SetVectorParallelism(parallel ? 1 << 20 : std::numeric_limits<size_t>::max());
+            const std::string_view mode = parallel ? "parallel" : "serial";
+            auto report = [&](std::string_view name, const Measurement& measurement) {
+                Report(name, mode, type, size, measurement);
+            };
+            if (std::string_view name = "Parallel construct+destroy"; name.find(options.filter) != std::string_view::npos) {
+                report(name, Measure(size, [] {
+                    return NoState{};
+                }, [size](NoState&) {
+                    Vector<T> v(size);
+                    DoNotOptimize(v);
+                }));
+            }
+            if (std::string_view name = "Parallel copy"; name.find(options.filter) != std::string_view::npos) {
+                const Vector<T> source(size);
+                report(name, Measure(size, [] {
+                    return NoState{};
+                }, [&source](NoState&) {
+                    Vector<T> copy(source);
+                    DoNotOptimize(copy);
+                }));
+            }
+        }
+        SetVectorParallelism(std::numeric_limits<size_t>::max());
+    }
+
+    // appends from several threads into one vector guarded by a mutex and into ConcurrentVector
+    void RunConcurrentAppends() {
+        const std::string_view name = "Concurrent append";
+        if (name.find(options.filter) == std::string_view::npos) {
+            return;
+        }
+        const size_t num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+        const size_t items_per_thread = std::max<size_t>(options.max_size / num_threads, 1);
+        auto run_threads = [num_threads](auto append) {
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < num_threads; ++t) {
+                threads.emplace_back(append);
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        };
+        auto no_setup = [] {
+            return NoState{};
+        };
+        Report(name, "Vector+mutex", "int", num_threads, Measure(num_threads * items_per_thread, no_setup,
+                                                                 [&](NoState&) {
+            Vector<int> v;
+            std::mutex mutex;
+            run_threads([&] {
+                for (size_t i = 0; i < items_per_thread; ++i) {
+                    std::lock_guard guard(mutex);
+                    v.PushBack(static_cast<int>(i));
+                }
+            });
+            DoNotOptimize(v);
+        }));
+        Report(name, "Concurrent", "int", num_threads, Measure(num_threads * items_per_thread, no_setup,
+                                                               [&](NoState&) {
+            ConcurrentVector<int> v;
+            run_threads([&] {
+                for (size_t i = 0; i < items_per_thread; ++i) {
+                    v.PushBack(static_cast<int>(i));
+                }
+            });
+            DoNotOptimize(v);
+        }));
+    }
+
+    // a FIFO queue of size items: every item is popped from the front and a new one is pushed back
+    void RunQueueCases(size_t size) {
+        const std::string_view name = "FIFO PopFront+PushBack";
+        if (name.find(options.filter) == std::string_view::npos) {
+            return;
+        }
+        auto make_queue = [size](auto queue) {
+            for (size_t i = 0; i < size; ++i) {
+                queue.PushBack(static_cast<int>(i));
+            }
+            return queue;
+        };
+        if (size <= options.max_quadratic_size) {
+            Report(name, "Vector", "int", size, Measure(size, [&] {
+                return make_queue(Vector<int>());
+            }, [size](Vector<int>& queue) {
+                for (size_t i = 0; i < size; ++i) {
+                    [[maybe_unused]] auto next = queue.Erase(queue.cbegin());
+                    queue.PushBack(static_cast<int>(i));
+                }
+            }));
+        }
+        Report(name, "RingVector", "int", size, Measure(size, [&] {
+            return make_queue(RingVector<int>());
+        }, [size](RingVector<int>& queue) {
+            for (size_t i = 0; i < size; ++i) {
+                queue.PopFront();
+                queue.PushBack(static_cast<int>(i));
+            }
+        }));
+    }
+
+    // hands a snapshot of size items to 16 readers that only read its first item
+    void RunSnapshotCopies(size_t size) {
+        const std::string_view name = "Snapshot to 16 readers";
+        if (name.find(options.filter) == std::string_view::npos) {
+            return;
+        }
+        constexpr size_t NUM_READERS = 16;
+        auto make_snapshot = [size](auto snapshot) {
+            for (size_t i = 0; i < size; ++i) {
+                snapshot.PushBack(static_cast<int>(i));
+            }
+            return snapshot;
+        };
+        Report(name, "Vector", "int", size, Measure(size, [&] {
+            return make_snapshot(Vector<int>());
+        }, [](const Vector<int>& snapshot) {
+            for (size_t i = 0; i < NUM_READERS; ++i) {
+                const Vector<int> reader(snapshot);
+                DoNotOptimize(reader[0]);
+            }
+        }));
+        Report(name, "CowVector", "int", size, Measure(size, [&] {
+            return make_snapshot(CowVector<int>());
+        }, [](const CowVector<int>& snapshot) {
+            for (size_t i = 0; i < NUM_READERS; ++i) {
+                const CowVector<int> reader(snapshot);
+                DoNotOptimize(reader[0]);
+            }
+        }));
+    }
+
+    // merges 8 partial results of size / 8 strings into one vector
+    void RunMerges(size_t size) {
+        const std::string_view name = "Merge of 8 parts";
+        if (name.find(options.filter) == std::string_view::npos) {
+            return;
+        }
+        constexpr size_t NUM_PARTS = 8;
+        auto make_parts = [size] {
+            Vector<Vector<std::string>> parts(NUM_PARTS);
+            for (size_t i = 0; i < size; ++i) {
+                parts[i % NUM_PARTS].PushBack(std::string(32, static_cast<char>('a' + i % 26)));
+            }
+            return parts;
+        };
+        Report(name, "Append", "string", size, Measure(size, make_parts, [](Vector<Vector<std::string>>& parts) {
+            Vector<std::string> merged;
+            for (const Vector<std::string>& part : parts) {
+                merged.Append(part.begin(), part.end());
+            }
+            DoNotOptimize(merged);
+        }));
+        Report(name, "AppendMove", "string", size, Measure(size, make_parts, [](Vector<Vector<std::string>>& parts) {
+            Vector<std::string> merged;
+            for (Vector<std::string>& part : parts) {
+                merged.AppendMove(std::move(part));
+            }
+            DoNotOptimize(merged);
+        }));
+    }
+
+    // sums one field of records of eight fields stored as rows and as columns
+    void RunFieldScans(size_t size) {
+        const std::string_view name = "Scan of one field";
+        if (name.find(options.filter) == std::string_view::npos) {
+            return;
+        }
+        struct Record {
+            int64_t fields[8];
+        };
+        Vector<Record> rows;
+        SoaVector<int64_t, int64_t, int64_t, int64_t, int64_t, int64_t, int64_t, int64_t> columns;
+        rows.Reserve(size);
+        columns.Reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            const auto value = static_cast<int64_t>(i);
+            rows.PushBack({ { value, value, value, value, value, value, value, value } });
+            columns.EmplaceBack(value, value, value, value, value, value, value, value);
+        }
+        auto no_setup = [] {
+            return NoState{};
+        };
+        Report(name, "Vector", "Record", size, Measure(size, no_setup, [&rows](NoState&) {
+            int64_t sum = 0;
+            for (const Record& record : rows) {
+                sum += record.fields[0];
+            }
+            DoNotOptimize(sum);
+        }));
+        Report(name, "SoaVector", "Record", size, Measure(size, no_setup, [&columns](NoState&) {
+            int64_t sum = 0;
+            for (int64_t field : columns.Column<0>()) {
+                sum += field;
+            }
+            DoNotOptimize(sum);
+        }));
+    }
+
+    // lookups of pseudo-random present keys, the same sequence for both maps
+    template <typename Map>
+    void RunMapLookups(std::string_view container, size_t size) {
+        const std::string_view name = "Map lookup";
+        if (name.find(options.filter) == std::string_view::npos) {
+            return;
+        }
+        Map map;
+        for (size_t i = 0; i < size; ++i) {
+            map[static_cast<int>(i * 2)] = static_cast<int>(i);
+        }
+        const size_t num_lookups = 1'000'000;
+        Report(name, container, "int", size, Measure(num_lookups, [] {
+            return NoState{};
+        }, [&map, size](NoState&) {
+            uint32_t state = 1;
+            int sum = 0;
+            for (size_t i = 0; i < num_lookups; ++i) {
+                state = state * 1664525 + 1013904223;
+                const auto key = static_cast<int>(state % size * 2);
+                if constexpr (std::is_same_v<Map, std::map<int, int>>) {
+                    sum += map.find(key)->second;
+                }
+                else {
+                    sum += *map.Find(key);
+                }
+            }
+            DoNotOptimize(sum);
+        }));
+    }
+
+    // the longest single PushBack while a container of strings grows to the maximal size;
+    // the time column shows the worst case in ns instead of the mean time per item
+    template <typename Container>
+    void RunAppendLatency(std::string_view container) {
+        const std::string_view name = "Worst PushBack latency";
+        if (name.find(options.filter) == std::string_view::npos) {
+            return;
+        }
+        using Clock = std::chrono::steady_clock;
+        ResetPeakRss();
+        Clock::duration worst{};
+        {
+            Container v;
+            const std::string item(32, 'x');
+            for (size_t i = 0; i < options.max_size; ++i) {
+                const auto start = Clock::now();
+                PushBack(v, item);
+                worst = std::max(worst, Clock::now() - start);
+            }
+            DoNotOptimize(v);
+        }
+        const auto worst_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(worst).count();
+        Report(name, container, "std::string", options.max_size,
+               { static_cast<double>(worst_ns), 0, GetPeakRssKb() });
+    }
+
+    bool ParseOptions(int argc, char* argv[]) {
+        using namespace std::literals;
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            if (arg.rfind("--max-size="sv, 0) == 0) {
+                options.max_size = static_cast<size_t>(std::stod(std::string(arg.substr(11))));
+            }
+            else if (arg.rfind("--filter="sv, 0) == 0) {
+                options.filter = arg.substr(9);
+            }
+            else if (arg.rfind("--min-time-ms="sv, 0) == 0) {
+                options.min_time = std::chrono::milliseconds(std::stol(std::string(arg.substr(14))));
+            }
+            else {
+                std::cerr << "Usage: "sv << argv[0] << " [--max-size=N] [--filter=SUBSTRING] [--min-time-ms=MS]"sv
+                          << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (!ParseOptions(argc, argv)) {
+        return 1;
+    }
+
+    std::printf("%-28s %-12s %-12s %10s %12s %14s %12s\n", "case", "container", "type", "size", "ns/item",
+                "allocs/run", "peak RSS KB");
+    RunType<int>("int");
+    // growth by mremap
+    for (size_t size = 1; size <= options.max_size; size *= 10) {
+        RunCases<Vector<int, MmapAllocator<int>>, int>("Vector+mmap", "int", size);
+    }
+    RunType<Pod64>("Pod64");
+    RunType<std::string>("std::string");
+    RunType<Obj>("Obj");
+
+    RunShortVectors<std::vector<int>>("std::vector");
+    RunShortVectors<Vector<int>>("Vector");
+    RunShortVectors<SmallVector<int, 8>>("SmallVector");
+    RunShortVectors<StaticVector<int, 8>>("StaticVector");
+    // an unused capacity is zeroed by every vector under C++17, not under C++20
+    RunShortVectors<StaticVector<int, 4096>>("Static 4096");
+    RunShortVectors<Vector<int, CachingAllocator<int>>>("Vector+cache");
+
+    RunBulkOperations<int>("int");
+    RunBulkOperations<float>("float");
+    RunBulkOperations<double>("double");
+
+    RunParallelCases<int>("int");
+    RunParallelCases<std::string>("std::string");
+
+    RunConcurrentAppends();
+
+    for (size_t size = 1000; size <= options.max_size; size *= 10) {
+        RunQueueCases(size);
+        RunSnapshotCopies(size);
+        RunMerges(size);
+        RunFieldScans(size);
+        RunMapLookups<std::map<int, int>>("std::map", size);
+        RunMapLookups<FlatMap<int, int>>("FlatMap", size);
+    }
+
+    RunAppendLatency<Vector<std::string>>("Vector");
+    RunAppendLatency<SegmentedVector<std::string>>("Segmented");
+    RunAppendLatency<IncrementalVector<std::string>>("Incremental");
+}
@@ -0,0 +1,270 @@
+#pragma once
+#include "geometric_segments.h"
+#include "vector.h"
+
+#include <atomic>
+#include <iterator>
+#include <memory>
+
+// vector that many threads may append to at once without a lock; the items are kept in
+// RawMemory segments of geometrically growing size, so they never move and references to them
+// stay valid until the vector is destroyed; items can't be removed
+template <typename T, typename Allocator = std::allocator<T>>
+class ConcurrentVector {
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "items built aside are moved into their slots, which must not fail");
+
+    using HeapMemory = RawMemory<T, Allocator>;
+    using ReadyAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::atomic<bool>>;
+    using ReadyFlags = RawMemory<std::atomic<bool>, ReadyAllocator>;
+    using Segments = vector_detail::GeometricSegments<32>;
+
+    static constexpr size_t MAX_SEGMENTS = Segments::MAX_SEGMENTS;
+
+    struct Segment {
+        Segment(size_t capacity, const Allocator& alloc)
+            : items(capacity, alloc)
+            , ready(capacity, ReadyAllocator(alloc)) {
+            std::uninitialized_value_construct_n(ready.GetAddress(), capacity);
+        }
+
+        HeapMemory items;
+        // set when the item of the slot is constructed
+        ReadyFlags ready;
+    };
+
+    using SegmentAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Segment>;
+    using SegmentTraits = std::allocator_traits<SegmentAllocator>;
+
+public:
+    using allocator_type = Allocator;
+
+    class Snapshot;
+
+    ConcurrentVector() = default;
+
+    explicit ConcurrentVector(const Allocator& alloc) noexcept
+        : alloc_(alloc) {
+    }
+
+    ConcurrentVector(const ConcurrentVector&) = delete;
+
+    ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+    // must not run concurrently with other operations
+    ~ConcurrentVector() {
+        for (size_t k = 0; k < MAX_SEGMENTS; ++k) {
+            Segment* segment = segments_[k].load(std::memory_order_acquire);
+            if (segment == nullptr) {
+                continue;
+            }
+            for (size_t i = 0; i < Segments::SegmentSize(k); ++i) {
+                if (segment->ready[i].load(std::memory_order_relaxed)) {
+                    segment->items[i].~T();
+                }
+            }
+            DeleteSegment(segment);
+        }
+    }
+
+    // lock-free: the slot is reserved with a compare-exchange only once its segment exists, and
+    // a missing segment is allocated by whoever needs it first, so a std::bad_alloc leaves
+    // nothing reserved; if args may throw, the item is built aside before a slot is reserved.
+    // Thus every reserved slot gets its item and snapshots never stop at a hole
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+            size_t index = reserved_.load(std::memory_order_relaxed);
+            Segment* segment = nullptr;
+            do {
+                segment = &GetOrAllocateSegment(Segments::SegmentOf(index));
+            } while (!reserved_.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+            const size_t offset = Segments::OffsetInSegment(index);
+            T* item = new (segment->items + offset) T(std::forward<Args>(args)...);
+            segment->ready[offset].store(true, std::memory_order_release);
+            return *item;
+        }
+        else {
+            T item(std::forward<Args>(args)...);
+            return EmplaceBack(std::move(item));
+        }
+    }
+
+    T& PushBack(const T& value) {
+        return EmplaceBack(value);
+    }
+
+    T& PushBack(T&& value) {
+        return EmplaceBack(std::move(value));
+    }
+
+    // the items that are constructed, with no gaps before them; it only grows
+    Snapshot GetSnapshot() const noexcept {
+        return Snapshot(*this, PublishedSize());
+    }
+
+    size_t Size() const noexcept {
+        return PublishedSize();
+    }
+
+    // index has to be below the size of a snapshot taken before
+    T& operator[](size_t index) noexcept {
+        assert(IsReady(index));
+        Segment* segment = segments_[Segments::SegmentOf(index)].load(std::memory_order_acquire);
+        return segment->items[Segments::OffsetInSegment(index)];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<ConcurrentVector&>(*this)[index];
+    }
+
+    Allocator GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+private:
+    Segment& GetOrAllocateSegment(size_t k) {
+        Segment* segment = segments_[k].load(std::memory_order_acquire);
+        if (segment != nullptr) {
+            return *segment;
+        }
+        Segment* new_segment = NewSegment(Segments::SegmentSize(k));
+        if (segments_[k].compare_exchange_strong(segment, new_segment, std::memory_order_acq_rel,
+                                                  std::memory_order_acquire)) {
+            return *new_segment;
+        }
+        // another thread was faster, its segment is used and ours is freed
+        DeleteSegment(new_segment);
+        return *segment;
+    }
+
+    // the segments and their ready flags come from the allocator of the vector too
+    Segment* NewSegment(size_t capacity) {
+        SegmentAllocator alloc(alloc_);
+        Segment* segment = SegmentTraits::allocate(alloc, 1);
+        try {
+            SegmentTraits::construct(alloc, segment, capacity, alloc_);
+        }
+        catch (...) {
+            SegmentTraits::deallocate(alloc, segment, 1);
+            throw;
+        }
+        return segment;
+    }
+
+    void DeleteSegment(Segment* segment) noexcept {
+        SegmentAllocator alloc(alloc_);
+        SegmentTraits::destroy(alloc, segment);
+        SegmentTraits::deallocate(alloc, segment, 1);
+    }
+
+    bool IsReady(size_t index) const noexcept {
+        const Segment* segment = segments_[Segments::SegmentOf(index)].load(std::memory_order_acquire);
+        return segment != nullptr
+            && segment->ready[Segments::OffsetInSegment(index)].load(std::memory_order_acquire);
+    }
+
+    // advances the published size over the items that became ready since the last call
+    size_t PublishedSize() const noexcept {
+        size_t published = published_.load(std::memory_order_acquire);
+        const size_t reserved = reserved_.load(std::memory_order_acquire);
+        size_t ready_end = published;
+        while (ready_end < reserved && IsReady(ready_end)) {
+            ++ready_end;
+        }
+        while (published < ready_end
+               && !published_.compare_exchange_weak(published, ready_end, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire)) {
+        }
+        return std::max(published, ready_end);
+    }
+
+    std::atomic<Segment*> segments_[MAX_SEGMENTS] = {};
+    // the counters are changed by different threads, so they don't share a cache line
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> reserved_{ 0 };
+    alignas(CACHE_LINE_SIZE) mutable std::atomic<size_t> published_{ 0 };
+    Allocator alloc_;
+};
+
+// read-only view of the first items of a ConcurrentVector; they are not changed by the writers,
+// so a snapshot may be read while the vector grows
+template <typename T, typename Allocator>
+class ConcurrentVector<T, Allocator>::Snapshot {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        Iterator() = default;
+
+        reference operator*() const noexcept {
+            return (*vector_)[index_];
+        }
+
+        pointer operator->() const noexcept {
+            return &**this;
+        }
+
+        Iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            Iterator old = *this;
+            ++index_;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const noexcept {
+            return index_ == other.index_;
+        }
+
+        bool operator!=(const Iterator& other) const noexcept {
+            return index_ != other.index_;
+        }
+
+    private:
+        friend class Snapshot;
+
+        Iterator(const ConcurrentVector* vector, size_t index) noexcept
+            : vector_(vector)
+            , index_(index) {
+        }
+
+        const ConcurrentVector* vector_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return (*vector_)[index];
+    }
+
+    Iterator begin() const noexcept {
+        return Iterator(vector_, 0);
+    }
+
+    Iterator end() const noexcept {
+        return Iterator(vector_, size_);
+    }
+
+private:
+    friend class ConcurrentVector;
+
+    Snapshot(const ConcurrentVector& vector, size_t size) noexcept
+        : vector_(&vector)
+        , size_(size) {
+    }
+
+    const ConcurrentVector* vector_;
+    size_t size_;
+};
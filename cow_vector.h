@@ -0,0 +1,264 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+
+// vector whose copies share one buffer of items: a copy costs O(1) and the items are copied only
+// by the first change of a copy whose buffer is shared, so many readers of a rarely changed snapshot
+// don't copy it. The reference count is atomic, copies may live in different threads; a single
+// CowVector object is not safe for concurrent changes. Pointers and iterators to the items are valid
+// until the next change, which may move the items to a private buffer
+template <typename T, typename Allocator = std::allocator<T>>
+class CowVector {
+    using GrowthPolicy = DoublingGrowth;
+    using Items = Vector<T, Allocator, GrowthPolicy>;
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+    struct Shared {
+        explicit Shared(Items&& items)
+            : items(std::move(items)) {
+        }
+
+        std::atomic<size_t> owners{ 1 };
+        Items items;
+    };
+
+    using SharedAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Shared>;
+    using SharedTraits = std::allocator_traits<SharedAllocator>;
+
+public:
+    using allocator_type = Allocator;
+    using value_type = T;
+    using const_iterator = typename Items::const_iterator;
+
+    CowVector() = default;
+
+    // takes the items without copying them
+    CowVector(Items&& items)
+        : shared_(MakeShared(std::move(items))) {
+    }
+
+    CowVector(std::initializer_list<T> items)
+        : CowVector(Items(items)) {
+    }
+
+    CowVector(const CowVector& other) noexcept
+        : shared_(other.shared_) {
+        if (shared_ != nullptr) {
+            shared_->owners.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    CowVector(CowVector&& other) noexcept
+        : shared_(std::exchange(other.shared_, nullptr)) {
+    }
+
+    CowVector& operator=(const CowVector& rhs) noexcept {
+        if (this != &rhs) {
+            CowVector rhs_copy(rhs);
+            Swap(rhs_copy);
+        }
+        return *this;
+    }
+
+    CowVector& operator=(CowVector&& rhs) noexcept {
+        if (this != &rhs) {
+            CowVector rhs_moved(std::move(rhs));
+            Swap(rhs_moved);
+        }
+        return *this;
+    }
+
+    ~CowVector() {
+        Unshare(shared_);
+    }
+
+    void Swap(CowVector& other) noexcept {
+        std::swap(shared_, other.shared_);
+    }
+
+    const_iterator begin() const noexcept {
+        return View().begin();
+    }
+
+    const_iterator end() const noexcept {
+        return View().end();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    size_t Size() const noexcept {
+        return shared_ == nullptr ? 0 : shared_->items.Size();
+    }
+
+    size_t Capacity() const noexcept {
+        return shared_ == nullptr ? 0 : shared_->items.Capacity();
+    }
+
+    // the number of CowVector objects sharing the items, 0 for an empty vector without a buffer
+    size_t UseCount() const noexcept {
+        return shared_ == nullptr ? 0 : shared_->owners.load(std::memory_order_relaxed);
+    }
+
+    bool IsShared() const noexcept {
+        return UseCount() > 1;
+    }
+
+    const Items& View() const noexcept {
+        static const Items EMPTY;
+        return shared_ == nullptr ? EMPTY : shared_->items;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return View()[index];
+    }
+
+    // the items for a change, copied first if they are shared
+    Items& Modify() {
+        return Modify(Size());
+    }
+
+    // copies shared items like any change, reads should go through a const vector
+    T& operator[](size_t index) {
+        return Modify()[index];
+    }
+
+    void Reserve(size_t capacity) {
+        if (capacity > Capacity()) {
+            Modify(capacity).Reserve(capacity);
+        }
+    }
+
+    // drops the items without copying them even if they are shared
+    void Clear() noexcept {
+        if (IsShared()) {
+            Unshare(std::exchange(shared_, nullptr));
+        }
+        else if (shared_ != nullptr) {
+            shared_->items.Clear();
+        }
+    }
+
+    void Resize(size_t new_size) {
+        Modify(std::max(new_size, Size())).Resize(new_size);
+    }
+
+    void PushBack(const T& value) {
+        [[maybe_unused]] T& item = EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        [[maybe_unused]] T& item = EmplaceBack(std::move(value));
+    }
+
+    // args may refer to the items, the shared ones are kept until the new item is built
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        const UnshareOnExit old{ Detach(CapacityForOneMore()) };
+        return shared_->items.EmplaceBack(std::forward<Args>(args)...);
+    }
+
+    void PopBack() {
+        Modify().PopBack();
+    }
+
+    // pos is an iterator of this vector from before the call
+    template <typename... Args>
+    const_iterator Emplace(const_iterator pos, Args&&... args) {
+        const size_t index = pos - cbegin();
+        const UnshareOnExit old{ Detach(CapacityForOneMore()) };
+        return shared_->items.Emplace(shared_->items.cbegin() + index, std::forward<Args>(args)...);
+    }
+
+    const_iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    const_iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    const_iterator Erase(const_iterator pos) {
+        const size_t index = pos - cbegin();
+        Items& items = Modify();
+        return items.Erase(items.cbegin() + index);
+    }
+
+    const_iterator Erase(const_iterator first, const_iterator last) {
+        const size_t index = first - cbegin();
+        const size_t count = last - first;
+        Items& items = Modify();
+        return items.Erase(items.cbegin() + index, items.cbegin() + index + count);
+    }
+
+private:
+    struct UnshareOnExit {
+        ~UnshareOnExit() {
+            Unshare(shared);
+        }
+
+        Shared* shared;
+    };
+
+    Items& Modify(size_t capacity) {
+        Unshare(Detach(capacity));
+        return shared_->items;
+    }
+
+    // the copy made for adding an item grows by the policy at once, so it doesn't reallocate right away
+    size_t CapacityForOneMore() const noexcept {
+        return GrowthPolicy::NewCapacity(Size(), Size() + 1, sizeof(T));
+    }
+
+    static Shared* MakeShared(Items&& items) {
+        SharedAllocator alloc(items.GetAllocator());
+        Shared* shared = SharedTraits::allocate(alloc, 1);
+        try {
+            SharedTraits::construct(alloc, shared, std::move(items));
+        }
+        catch (...) {
+            SharedTraits::deallocate(alloc, shared, 1);
+            throw;
+        }
+        return shared;
+    }
+
+    // gives this vector items of its own, copying the shared ones into a buffer for at least capacity
+    // items; returns the items it shared before, which the caller gives up with Unshare when they
+    // aren't needed anymore, or nullptr
+    Shared* Detach(size_t capacity) {
+        if (shared_ == nullptr) {
+            shared_ = MakeShared(Items());
+            return nullptr;
+        }
+        // acquire pairs with the release of the owners that gave up the items, so their reads
+        // happen before the changes
+        if (shared_->owners.load(std::memory_order_acquire) == 1) {
+            return nullptr;
+        }
+        const Items& shared_items = shared_->items;
+        Items items(AllocTraits::select_on_container_copy_construction(shared_items.GetAllocator()));
+        items.Reserve(std::max(capacity, shared_items.Size()));
+        items.Append(shared_items.begin(), shared_items.end());
+        Shared* copy = MakeShared(std::move(items));
+        return std::exchange(shared_, copy);
+    }
+
+    // the last owner destroys the items
+    static void Unshare(Shared* shared) noexcept {
+        if (shared != nullptr && shared->owners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            SharedAllocator alloc(shared->items.GetAllocator());
+            SharedTraits::destroy(alloc, shared);
+            SharedTraits::deallocate(alloc, shared, 1);
+        }
+    }
+
+    Shared* shared_ = nullptr;
+};
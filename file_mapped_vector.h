@@ -0,0 +1,253 @@
+#pragma once
+#include "mmap_allocator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// vector of trivially copyable items that lives in a shared mapping of a file: the items and
+// the size are written straight into the page cache, so they survive a crash of the process,
+// and opening the file maps it back without reading or copying anything. The size is stored
+// only after the items it covers, so a crash of the process never leaves the size counting an
+// unwritten item. Sync() flushes the pages to the disk for the case of a crash of the system;
+// the system writes the pages back in any order, so the changes made after the last Sync()
+// may be lost then, and the size may count items whose page wasn't written. The file is a
+// 64 byte header and the items after it; growth makes the file longer and remaps it with mremap
+template <typename T, typename GrowthPolicy = DoublingGrowth>
+class FileMappedVector {
+    static_assert(std::is_trivially_copyable_v<T>, "the bytes of the items are stored in the file as they are");
+    static_assert(alignof(T) <= 64, "the items follow the 64 byte header");
+
+    static constexpr uint64_t MAGIC = 0x56454354'4f52'4d4dULL;  // "VECTORMM"
+    static constexpr uint32_t VERSION = 1;
+
+    struct alignas(64) Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t item_size;
+        uint64_t size;
+    };
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    // creates an empty vector, an existing file is truncated
+    static FileMappedVector Create(const std::string& path, size_t capacity = 0) {
+        FileMappedVector vector(OpenFile(path, O_RDWR | O_CREAT | O_TRUNC));
+        vector.Map(FileBytes(capacity));
+        *vector.header_ = Header{ MAGIC, VERSION, sizeof(T), 0 };
+        return vector;
+    }
+
+    // maps a file made by Create, the items are available without reading them
+    static FileMappedVector Open(const std::string& path) {
+        FileMappedVector vector(OpenFile(path, O_RDWR));
+        struct stat file_stat {};
+        if (fstat(vector.fd_, &file_stat) != 0) {
+            vector_detail::ThrowSystemError("fstat");
+        }
+        const size_t file_bytes = static_cast<size_t>(file_stat.st_size);
+        if (file_bytes < sizeof(Header)) {
+            throw std::runtime_error("not a file of FileMappedVector");
+        }
+        vector.Map(file_bytes);
+        const Header& header = *vector.header_;
+        if (header.magic != MAGIC || header.version != VERSION || header.item_size != sizeof(T)
+            || header.size > vector.capacity_) {
+            throw std::runtime_error("not a file of FileMappedVector of this item type");
+        }
+        return vector;
+    }
+
+    FileMappedVector(const FileMappedVector&) = delete;
+
+    FileMappedVector& operator=(const FileMappedVector&) = delete;
+
+    FileMappedVector(FileMappedVector&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1))
+        , header_(std::exchange(other.header_, nullptr))
+        , mapping_bytes_(std::exchange(other.mapping_bytes_, 0))
+        , capacity_(std::exchange(other.capacity_, 0)) {
+    }
+
+    FileMappedVector& operator=(FileMappedVector&& rhs) noexcept {
+        if (this != &rhs) {
+            Close();
+            fd_ = std::exchange(rhs.fd_, -1);
+            header_ = std::exchange(rhs.header_, nullptr);
+            mapping_bytes_ = std::exchange(rhs.mapping_bytes_, 0);
+            capacity_ = std::exchange(rhs.capacity_, 0);
+        }
+        return *this;
+    }
+
+    // the pages are written back by the system later, see Sync()
+    ~FileMappedVector() {
+        Close();
+    }
+
+    iterator begin() noexcept {
+        return Items();
+    }
+
+    iterator end() noexcept {
+        return Items() + Size();
+    }
+
+    const_iterator begin() const noexcept {
+        return const_cast<FileMappedVector&>(*this).begin();
+    }
+
+    const_iterator end() const noexcept {
+        return const_cast<FileMappedVector&>(*this).end();
+    }
+
+    size_t Size() const noexcept {
+        return header_ == nullptr ? 0 : header_->size;
+    }
+
+    size_t Capacity() const noexcept {
+        return capacity_;
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < Size());
+        return Items()[index];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<FileMappedVector&>(*this)[index];
+    }
+
+    void Reserve(size_t capacity) {
+        if (capacity > capacity_) {
+            Remap(FileBytes(capacity));
+        }
+    }
+
+    // new items are zeroed before the size covers them
+    void Resize(size_t new_size) {
+        if (new_size > capacity_) {
+            Grow(new_size);
+        }
+        if (new_size > Size()) {
+            std::memset(static_cast<void*>(Items() + Size()), 0, (new_size - Size()) * sizeof(T));
+            AfterItemsWritten();
+        }
+        header_->size = new_size;
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        // the value is built first as args may refer to an item of the old mapping
+        T value(std::forward<Args>(args)...);
+        if (Size() == capacity_) {
+            Grow(Size() + 1);
+        }
+        T* item = new (Items() + Size()) T(value);
+        AfterItemsWritten();
+        ++header_->size;
+        return *item;
+    }
+
+    void PopBack() noexcept {
+        assert(Size() != 0);
+        --header_->size;
+    }
+
+    void Clear() noexcept {
+        if (header_ != nullptr) {
+            header_->size = 0;
+        }
+    }
+
+    // writes the changed pages to the disk
+    void Sync() {
+        if (header_ != nullptr && msync(header_, mapping_bytes_, MS_SYNC) != 0) {
+            vector_detail::ThrowSystemError("msync");
+        }
+    }
+
+private:
+    explicit FileMappedVector(int fd) noexcept
+        : fd_(fd) {
+    }
+
+    static int OpenFile(const std::string& path, int flags) {
+        const int fd = open(path.c_str(), flags | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            vector_detail::ThrowSystemError("open");
+        }
+        return fd;
+    }
+
+    static size_t FileBytes(size_t capacity) {
+        if (capacity > (std::numeric_limits<size_t>::max() - sizeof(Header)) / sizeof(T) - vector_detail::PageSize()) {
+            throw std::length_error("FileMappedVector is too long");
+        }
+        return vector_detail::RoundUpTo(sizeof(Header) + capacity * sizeof(T), vector_detail::PageSize());
+    }
+
+    // keeps the compiler from moving the stores of the items after the following store of the size;
+    // a crashing process stops between two instructions of this thread like a signal handler does,
+    // and the stores it has made are in the page cache, so no CPU fence is needed
+    static void AfterItemsWritten() noexcept {
+        std::atomic_signal_fence(std::memory_order_release);
+    }
+
+    T* Items() noexcept {
+        return reinterpret_cast<T*>(reinterpret_cast<unsigned char*>(header_) + sizeof(Header));
+    }
+
+    void Map(size_t file_bytes) {
+        if (static_cast<size_t>(lseek(fd_, 0, SEEK_END)) < file_bytes && ftruncate(fd_, file_bytes) != 0) {
+            vector_detail::ThrowSystemError("ftruncate");
+        }
+        header_ = static_cast<Header*>(vector_detail::MapMemory(file_bytes, fd_));
+        SetMappingBytes(file_bytes);
+    }
+
+    void Grow(size_t required) {
+        Remap(FileBytes(GrowthPolicy::NewCapacity(capacity_, required, sizeof(T))));
+    }
+
+    // the file is extended first, so the mapping never goes beyond its end
+    void Remap(size_t file_bytes) {
+        if (ftruncate(fd_, file_bytes) != 0) {
+            vector_detail::ThrowSystemError("ftruncate");
+        }
+        header_ = static_cast<Header*>(vector_detail::RemapMemory(header_, mapping_bytes_, file_bytes, fd_));
+        SetMappingBytes(file_bytes);
+    }
+
+    void SetMappingBytes(size_t bytes) noexcept {
+        mapping_bytes_ = bytes;
+        capacity_ = (bytes - sizeof(Header)) / sizeof(T);
+    }
+
+    void Close() noexcept {
+        if (header_ != nullptr) {
+            munmap(header_, mapping_bytes_);
+            header_ = nullptr;
+        }
+        if (fd_ != -1) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd_ = -1;
+    Header* header_ = nullptr;
+    size_t mapping_bytes_ = 0;
+    size_t capacity_ = 0;
+};
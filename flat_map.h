@@ -0,0 +1,325 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+// Sorted associative containers over Vector with the semantics of C++23 flat_set and flat_map:
+// the keys are unique and kept sorted in one contiguous buffer, FlatMap keeps the values in a
+// separate one, so lookups scan only keys. Lookups are binary searches without a branch on the
+// comparisons; inserting one key shifts the tail, batches should go through InsertRange
+
+namespace vector_detail {
+
+    // the first index whose key is not less than key; halving the range with a conditional move in place
+    // of a branch keeps mispredictions out of the loop, which is what dominates std::lower_bound on big arrays
+    template <typename Key, typename Compare>
+    size_t BranchlessLowerBound(const Key* keys, size_t size, const Key& key, const Compare& comp) {
+        if (size == 0) {
+            return 0;
+        }
+        const Key* base = keys;
+        while (size > 1) {
+            const size_t half = size / 2;
+            base = comp(base[half], key) ? base + half : base;
+            size -= half;
+        }
+        return static_cast<size_t>(base - keys) + (comp(*base, key) ? 1 : 0);
+    }
+
+}  // namespace vector_detail
+
+template <typename Key, typename Compare = std::less<Key>, typename KeyContainer = Vector<Key>>
+class FlatSet : private Compare {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using iterator = typename KeyContainer::const_iterator;
+    using const_iterator = typename KeyContainer::const_iterator;
+
+    FlatSet() = default;
+
+    explicit FlatSet(const Compare& comp)
+        : Compare(comp) {
+    }
+
+    FlatSet(std::initializer_list<Key> keys, const Compare& comp = Compare())
+        : Compare(comp) {
+        InsertRange(keys.begin(), keys.end());
+    }
+
+    const_iterator begin() const noexcept {
+        return keys_.begin();
+    }
+
+    const_iterator end() const noexcept {
+        return keys_.end();
+    }
+
+    size_t Size() const noexcept {
+        return keys_.Size();
+    }
+
+    const KeyContainer& Keys() const noexcept {
+        return keys_;
+    }
+
+    void Reserve(size_t capacity) {
+        keys_.Reserve(capacity);
+    }
+
+    void Clear() noexcept {
+        keys_.Clear();
+    }
+
+    const_iterator LowerBound(const Key& key) const {
+        return begin() + vector_detail::BranchlessLowerBound(keys_.Data(), keys_.Size(), key, Comp());
+    }
+
+    const_iterator Find(const Key& key) const {
+        const const_iterator it = LowerBound(key);
+        return it != end() && !Comp()(key, *it) ? it : end();
+    }
+
+    bool Contains(const Key& key) const {
+        return Find(key) != end();
+    }
+
+    std::pair<const_iterator, bool> Insert(const Key& key) {
+        const const_iterator it = LowerBound(key);
+        if (it != end() && !Comp()(key, *it)) {
+            return { it, false };
+        }
+        return { keys_.Insert(it, key), true };
+    }
+
+    // appends the keys, sorts them and merges them with the old ones in place, so a batch costs
+    // O(n + m log m) instead of m shifts of the tail. A comparator that throws leaves the set empty,
+    // as the old keys may be half merged by then
+    template <typename InputIt>
+    void InsertRange(InputIt first, InputIt last) {
+        const size_t old_size = keys_.Size();
+        keys_.Append(first, last);
+        try {
+            const auto middle = keys_.begin() + old_size;
+            std::sort(middle, keys_.end(), Comp());
+            if (old_size != 0) {
+                std::inplace_merge(keys_.begin(), middle, keys_.end(), Comp());
+            }
+            // the merge is stable, so the old key of an equivalent pair stays
+            const auto unique_end = std::unique(keys_.begin(), keys_.end(), [this](const Key& lhs, const Key& rhs) {
+                return !Comp()(lhs, rhs);
+            });
+            keys_.Erase(unique_end, keys_.end());
+        }
+        catch (...) {
+            Clear();
+            throw;
+        }
+    }
+
+    size_t Erase(const Key& key) {
+        const const_iterator it = Find(key);
+        if (it == end()) {
+            return 0;
+        }
+        [[maybe_unused]] auto next = keys_.Erase(it);
+        return 1;
+    }
+
+private:
+    const Compare& Comp() const noexcept {
+        return *this;
+    }
+
+    KeyContainer keys_;
+};
+
+template <typename Key, typename Value, typename Compare = std::less<Key>, typename KeyContainer = Vector<Key>,
+          typename ValueContainer = Vector<Value>>
+class FlatMap : private Compare {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+
+    FlatMap() = default;
+
+    explicit FlatMap(const Compare& comp)
+        : Compare(comp) {
+    }
+
+    FlatMap(std::initializer_list<std::pair<Key, Value>> items, const Compare& comp = Compare())
+        : Compare(comp) {
+        InsertRange(items.begin(), items.end());
+    }
+
+    size_t Size() const noexcept {
+        return keys_.Size();
+    }
+
+    // the i-th value belongs to the i-th key
+    const KeyContainer& Keys() const noexcept {
+        return keys_;
+    }
+
+    ValueContainer& Values() noexcept {
+        return values_;
+    }
+
+    const ValueContainer& Values() const noexcept {
+        return values_;
+    }
+
+    void Reserve(size_t capacity) {
+        keys_.Reserve(capacity);
+        values_.Reserve(capacity);
+    }
+
+    void Clear() noexcept {
+        keys_.Clear();
+        values_.Clear();
+    }
+
+    // nullptr if there is no such key; the pointer is valid until the map changes
+    Value* Find(const Key& key) {
+        const size_t index = IndexOf(key);
+        return index == keys_.Size() ? nullptr : &values_[index];
+    }
+
+    const Value* Find(const Key& key) const {
+        return const_cast<FlatMap&>(*this).Find(key);
+    }
+
+    bool Contains(const Key& key) const {
+        return IndexOf(key) != keys_.Size();
+    }
+
+    Value& At(const Key& key) {
+        Value* value = Find(key);
+        if (value == nullptr) {
+            throw std::out_of_range("FlatMap::At: no such key");
+        }
+        return *value;
+    }
+
+    const Value& At(const Key& key) const {
+        return const_cast<FlatMap&>(*this).At(key);
+    }
+
+    // inserts a value-initialized value if there is no such key
+    Value& operator[](const Key& key) {
+        return *TryEmplace(key).first;
+    }
+
+    // builds a value from args only if there is no such key, returns the value and whether it was inserted
+    template <typename... Args>
+    std::pair<Value*, bool> TryEmplace(const Key& key, Args&&... args) {
+        const size_t index = vector_detail::BranchlessLowerBound(keys_.Data(), keys_.Size(), key, Comp());
+        if (index != keys_.Size() && !Comp()(key, keys_[index])) {
+            return { &values_[index], false };
+        }
+        [[maybe_unused]] auto key_it = keys_.Insert(keys_.begin() + index, key);
+        try {
+            [[maybe_unused]] auto value_it = values_.Emplace(values_.begin() + index, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            [[maybe_unused]] auto next = keys_.Erase(keys_.begin() + index);
+            throw;
+        }
+        return { &values_[index], true };
+    }
+
+    std::pair<Value*, bool> Insert(const Key& key, const Value& value) {
+        return TryEmplace(key, value);
+    }
+
+    template <typename V>
+    std::pair<Value*, bool> InsertOrAssign(const Key& key, V&& value) {
+        const auto result = TryEmplace(key, std::forward<V>(value));
+        if (!result.second) {
+            *result.first = std::forward<V>(value);
+        }
+        return result;
+    }
+
+    // inserts the pairs of [first, last) whose keys are not in the map yet: the pairs are sorted and
+    // merged with the map in one pass, which costs O(n + m log m) instead of m shifts of the tail;
+    // of the pairs with equivalent keys the first one is taken. The map stays untouched if an exception
+    // is thrown, as items that may throw on move are copied, except that a comparator throwing after
+    // old items were moved out leaves it empty
+    template <typename InputIt>
+    void InsertRange(InputIt first, InputIt last) {
+        Vector<std::pair<Key, Value>> batch(first, last);
+        if (batch.Size() == 0) {
+            return;
+        }
+        std::stable_sort(batch.begin(), batch.end(), [this](const auto& lhs, const auto& rhs) {
+            return Comp()(lhs.first, rhs.first);
+        });
+
+        KeyContainer keys;
+        ValueContainer values;
+        keys.Reserve(keys_.Size() + batch.Size());
+        values.Reserve(keys_.Size() + batch.Size());
+        size_t index = 0;
+        auto take_old = [&] {
+            keys.PushBack(std::move_if_noexcept(keys_[index]));
+            values.PushBack(std::move_if_noexcept(values_[index]));
+            ++index;
+        };
+        try {
+            for (auto& [key, value] : batch) {
+                while (index != keys_.Size() && Comp()(keys_[index], key)) {
+                    take_old();
+                }
+                const bool is_old = index != keys_.Size() && !Comp()(key, keys_[index]);
+                const bool is_repeated = keys.Size() != 0 && !Comp()(keys[keys.Size() - 1], key);
+                if (!is_old && !is_repeated) {
+                    keys.PushBack(std::move(key));
+                    values.PushBack(std::move(value));
+                }
+            }
+        }
+        catch (...) {
+            // what std::move_if_noexcept moves out of the old containers
+            constexpr bool MOVES_KEYS = std::is_nothrow_move_constructible_v<Key> || !std::is_copy_constructible_v<Key>;
+            constexpr bool MOVES_VALUES = std::is_nothrow_move_constructible_v<Value>
+                || !std::is_copy_constructible_v<Value>;
+            if ((MOVES_KEYS || MOVES_VALUES) && index != 0) {
+                Clear();
+            }
+            throw;
+        }
+        while (index != keys_.Size()) {
+            take_old();
+        }
+        keys_ = std::move(keys);
+        values_ = std::move(values);
+    }
+
+    size_t Erase(const Key& key) {
+        const size_t index = IndexOf(key);
+        if (index == keys_.Size()) {
+            return 0;
+        }
+        [[maybe_unused]] auto next_key = keys_.Erase(keys_.begin() + index);
+        [[maybe_unused]] auto next_value = values_.Erase(values_.begin() + index);
+        return 1;
+    }
+
+private:
+    const Compare& Comp() const noexcept {
+        return *this;
+    }
+
+    // the index of key or Size() if there is no such key
+    size_t IndexOf(const Key& key) const {
+        const size_t index = vector_detail::BranchlessLowerBound(keys_.Data(), keys_.Size(), key, Comp());
+        return index != keys_.Size() && !Comp()(key, keys_[index]) ? index : keys_.Size();
+    }
+
+    KeyContainer keys_;
+    ValueContainer values_;
+};
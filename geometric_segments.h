@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+
+namespace vector_detail {
+
+    // indexing of items kept in segments of FIRST_SIZE << k items: segment k starts
+    // at item FIRST_SIZE * (2^k - 1), so a few dozen segments cover any size
+    template <size_t FIRST_SIZE>
+    struct GeometricSegments {
+        static_assert(FIRST_SIZE != 0 && (FIRST_SIZE & (FIRST_SIZE - 1)) == 0, "FIRST_SIZE must be a power of two");
+
+        static constexpr size_t FIRST_BITS = [] {
+            size_t bits = 0;
+            while ((size_t{ 1 } << bits) != FIRST_SIZE) {
+                ++bits;
+            }
+            return bits;
+        }();
+
+        static constexpr size_t MAX_SEGMENTS = std::numeric_limits<size_t>::digits - FIRST_BITS;
+
+        static size_t SegmentSize(size_t segment) noexcept {
+            return FIRST_SIZE << segment;
+        }
+
+        // the index of the first item of segment, also the number of items in the segments before it
+        static size_t SegmentBegin(size_t segment) noexcept {
+            return SegmentSize(segment) - FIRST_SIZE;
+        }
+
+        // the index of the highest set bit of (index / FIRST_SIZE + 1)
+        static size_t SegmentOf(size_t index) noexcept {
+            const size_t value = (index >> FIRST_BITS) + 1;
+#if defined(__GNUC__)
+            return std::numeric_limits<unsigned long long>::digits - 1 - __builtin_clzll(value);
+#else
+            size_t segment = 0;
+            while (value >> (segment + 1) != 0) {
+                ++segment;
+            }
+            return segment;
+#endif
+        }
+
+        static size_t OffsetInSegment(size_t index) noexcept {
+            return index - SegmentBegin(SegmentOf(index));
+        }
+    };
+
+}  // namespace vector_detail
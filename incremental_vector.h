@@ -0,0 +1,306 @@
+#pragma once
+#include "index_iterator.h"
+#include "vector.h"
+
+// vector whose growth doesn't relocate all items at once: a full vector allocates a bigger buffer
+// and puts new items there, while every following push moves MIGRATION_STEP old items over, so
+// the old buffer is empty long before the new one is full. Until then operator[] finds an item
+// in one of the two buffers. The worst case of PushBack is one allocation and MIGRATION_STEP moves
+template <typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth,
+          size_t MIGRATION_STEP = 2>
+class IncrementalVector {
+    static_assert(std::is_nothrow_move_constructible_v<T>, "items are moved between the buffers by noexcept operations");
+    static_assert(MIGRATION_STEP != 0);
+
+    using HeapMemory = RawMemory<T, Allocator>;
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+public:
+    using allocator_type = Allocator;
+    using value_type = T;
+    using iterator = vector_detail::IndexIterator<IncrementalVector, false>;
+    using const_iterator = vector_detail::IndexIterator<IncrementalVector, true>;
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator(this, size_);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    IncrementalVector() = default;
+
+    explicit IncrementalVector(const Allocator& alloc) noexcept
+        : data_(alloc)
+        , old_data_(alloc) {
+    }
+
+    IncrementalVector(const IncrementalVector& other)
+        : IncrementalVector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {
+    }
+
+    IncrementalVector(const IncrementalVector& other, const Allocator& alloc)
+        : IncrementalVector(alloc) {
+        Reserve(other.size_);
+        for (const T& item : other) {
+            PushBack(item);
+        }
+    }
+
+    IncrementalVector(IncrementalVector&& other) noexcept
+        : data_(std::move(other.data_))
+        , old_data_(std::move(other.old_data_))
+        , size_(std::exchange(other.size_, 0))
+        , old_size_(std::exchange(other.old_size_, 0))
+        , migrated_(std::exchange(other.migrated_, 0)) {
+    }
+
+    // the items are moved one by one if the buffers of other can't be freed by alloc
+    IncrementalVector(IncrementalVector&& other, const Allocator& alloc)
+        : IncrementalVector(alloc) {
+        if (data_.HasEqualAllocator(other.data_)) {
+            TakeItems(other);
+        }
+        else {
+            Reserve(other.size_);
+            for (T& item : other) {
+                PushBack(std::move(item));
+            }
+            other.Clear();
+        }
+    }
+
+    // the copy is made with the allocator that *this has after the assignment, so its buffer
+    // can be taken over even if the allocators don't propagate
+    IncrementalVector& operator=(const IncrementalVector& rhs) {
+        if (this != &rhs) {
+            constexpr bool PROPAGATE = AllocTraits::propagate_on_container_copy_assignment::value;
+            IncrementalVector rhs_copy(rhs, PROPAGATE ? rhs.GetAllocator() : GetAllocator());
+            Clear();
+            if constexpr (PROPAGATE) {
+                data_.ResetAllocator(rhs_copy.GetAllocator());
+                old_data_.ResetAllocator(rhs_copy.GetAllocator());
+            }
+            TakeItems(rhs_copy);
+        }
+        return *this;
+    }
+
+    IncrementalVector& operator=(IncrementalVector&& rhs) noexcept(
+        AllocTraits::propagate_on_container_move_assignment::value || AllocTraits::is_always_equal::value) {
+        if (this != &rhs) {
+            if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                Clear();
+                TakeItems(rhs);
+            }
+            else if (data_.HasEqualAllocator(rhs.data_)) {
+                Clear();
+                TakeItems(rhs);
+            }
+            else { // buffers of rhs can't be freed by the allocator of *this, move elements one by one
+                IncrementalVector rhs_moved(std::move(rhs), GetAllocator());
+                Clear();
+                TakeItems(rhs_moved);
+            }
+        }
+        return *this;
+    }
+
+    ~IncrementalVector() {
+        Clear();
+    }
+
+    void Swap(IncrementalVector& other) noexcept {
+        data_.Swap(other.data_);
+        old_data_.Swap(other.old_data_);
+        std::swap(size_, other.size_);
+        std::swap(old_size_, other.old_size_);
+        std::swap(migrated_, other.migrated_);
+    }
+
+    Allocator GetAllocator() const noexcept {
+        return data_.GetAllocator();
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return data_.Capacity();
+    }
+
+    // true while some items are still in the old buffer
+    bool IsMigrating() const noexcept {
+        return migrated_ != old_size_;
+    }
+
+    // items [migrated_, old_size_) are still in the old buffer, the rest are in the new one
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return Slot(index);
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<IncrementalVector&>(*this)[index];
+    }
+
+    // moves the remaining old items, after it the items are contiguous
+    void FinishMigration() noexcept {
+        Migrate(old_size_ - migrated_);
+    }
+
+    // contiguous items, valid only when no migration is in progress
+    T* Data() noexcept {
+        assert(!IsMigrating());
+        return data_.GetAddress();
+    }
+
+    // relocates everything at once like Vector does
+    void Reserve(size_t capacity) {
+        if (capacity <= data_.Capacity()) {
+            return;
+        }
+        HeapMemory new_data(capacity, GetAllocator());
+        FinishMigration();
+        RelocateItems(data_.GetAddress(), new_data.GetAddress(), size_);
+        data_.Swap(new_data);
+    }
+
+    void Clear() noexcept {
+        while (size_ != 0) {
+            PopBack();
+        }
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        assert(size_ != 0);
+        --size_;
+        std::destroy_at(&Slot(size_));
+        if (old_size_ > size_) {
+            old_size_ = size_;
+            migrated_ = std::min(migrated_, old_size_);
+            if (!IsMigrating()) {
+                ReleaseOldData();
+            }
+        }
+        Migrate(MIGRATION_STEP);
+    }
+
+    // args may refer to an item, the old buffer is alive until the new item is built
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == data_.Capacity()) {
+            if (IsMigrating()) {
+                // the migration that is finished first moves the item that args may refer to
+                T value(std::forward<Args>(args)...);
+                StartMigration();
+                return EmplaceBack(std::move(value));
+            }
+            StartMigration();
+        }
+        T* item = new (data_ + size_) T(std::forward<Args>(args)...);
+        ++size_;
+        Migrate(MIGRATION_STEP);
+        return *item;
+    }
+
+private:
+    // *this is empty, other is left empty without buffers; the buffers of other have to be ones
+    // that the allocator of *this can free after the move assignments
+    void TakeItems(IncrementalVector& other) noexcept {
+        data_ = std::move(other.data_);
+        old_data_ = std::move(other.old_data_);
+        size_ = std::exchange(other.size_, 0);
+        old_size_ = std::exchange(other.old_size_, 0);
+        migrated_ = std::exchange(other.migrated_, 0);
+    }
+
+    T& Slot(size_t index) noexcept {
+        return index >= migrated_ && index < old_size_ ? old_data_[index] : data_[index];
+    }
+
+    // the current buffer becomes the old one; a migration that isn't finished yet,
+    // which happens only if the growth policy grows by less than 1 + 1 / MIGRATION_STEP, ends first
+    void StartMigration() {
+        HeapMemory new_data(GrowthPolicy::NewCapacity(data_.Capacity(), size_ + 1, sizeof(T)), GetAllocator());
+        FinishMigration();
+        if constexpr (VECTOR_STATS_ENABLED) {
+            ++vector_detail::LocalStats().reallocations;
+        }
+        old_data_.Swap(data_);
+        data_.Swap(new_data);
+        old_size_ = size_;
+        migrated_ = 0;
+        if (old_size_ == 0) {
+            ReleaseOldData();
+        }
+    }
+
+    void Migrate(size_t count) noexcept {
+        count = std::min(count, old_size_ - migrated_);
+        if (count == 0) {
+            return;
+        }
+        RelocateItems(old_data_ + migrated_, data_ + migrated_, count);
+        migrated_ += count;
+        if (!IsMigrating()) {
+            ReleaseOldData();
+        }
+    }
+
+    void ReleaseOldData() noexcept {
+        HeapMemory empty(GetAllocator());
+        old_data_.Swap(empty);
+    }
+
+    static void RelocateItems(T* from, T* to, size_t count) noexcept {
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            if (count != 0) {
+                std::memcpy(static_cast<void*>(to), from, count * sizeof(T));
+            }
+            if constexpr (VECTOR_STATS_ENABLED) {
+                vector_detail::LocalStats().items_relocated += count;
+            }
+        }
+        else {
+            std::uninitialized_move_n(from, count, to);
+            std::destroy_n(from, count);
+            if constexpr (VECTOR_STATS_ENABLED) {
+                vector_detail::LocalStats().items_moved += count;
+            }
+        }
+    }
+
+    HeapMemory data_;
+    HeapMemory old_data_;
+    size_t size_ = 0;
+    // the size when the migration started and the number of items moved to data_ since then
+    size_t old_size_ = 0;
+    size_t migrated_ = 0;
+};
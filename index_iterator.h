@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace vector_detail {
+
+    // random access iterator over a container with operator[] whose items aren't contiguous;
+    // operator[] may return a proxy object in place of a reference, then there is no operator->
+    template <typename Container, bool IS_CONST>
+    class IndexIterator {
+        using ContainerRef = std::conditional_t<IS_CONST, const Container, Container>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename Container::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IS_CONST, const value_type*, value_type*>;
+        using reference = decltype(std::declval<ContainerRef&>()[size_t{}]);
+
+        IndexIterator() = default;
+
+        IndexIterator(ContainerRef* container, size_t index) noexcept
+            : container_(container)
+            , index_(index) {
+        }
+
+        // iterator converts to const_iterator
+        template <bool OTHER_CONST, typename = std::enable_if_t<IS_CONST && !OTHER_CONST>>
+        IndexIterator(const IndexIterator<Container, OTHER_CONST>& other) noexcept
+            : container_(other.container_)
+            , index_(other.index_) {
+        }
+
+        reference operator*() const noexcept {
+            return (*container_)[index_];
+        }
+
+        pointer operator->() const noexcept {
+            return &**this;
+        }
+
+        reference operator[](difference_type offset) const noexcept {
+            return (*container_)[index_ + offset];
+        }
+
+        IndexIterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        IndexIterator operator++(int) noexcept {
+            IndexIterator old = *this;
+            ++index_;
+            return old;
+        }
+
+        IndexIterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+
+        IndexIterator operator--(int) noexcept {
+            IndexIterator old = *this;
+            --index_;
+            return old;
+        }
+
+        IndexIterator& operator+=(difference_type offset) noexcept {
+            index_ += offset;
+            return *this;
+        }
+
+        IndexIterator& operator-=(difference_type offset) noexcept {
+            index_ -= offset;
+            return *this;
+        }
+
+        friend IndexIterator operator+(IndexIterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+
+        friend IndexIterator operator+(difference_type offset, IndexIterator it) noexcept {
+            return it += offset;
+        }
+
+        friend IndexIterator operator-(IndexIterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const IndexIterator& lhs, const IndexIterator& rhs) noexcept {
+            return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+        }
+
+        friend bool operator==(const IndexIterator& lhs, const IndexIterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend bool operator!=(const IndexIterator& lhs, const IndexIterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+
+        friend bool operator<(const IndexIterator& lhs, const IndexIterator& rhs) noexcept {
+            return lhs.index_ < rhs.index_;
+        }
+
+        friend bool operator>(const IndexIterator& lhs, const IndexIterator& rhs) noexcept {
+            return rhs < lhs;
+        }
+
+        friend bool operator<=(const IndexIterator& lhs, const IndexIterator& rhs) noexcept {
+            return !(rhs < lhs);
+        }
+
+        friend bool operator>=(const IndexIterator& lhs, const IndexIterator& rhs) noexcept {
+            return !(lhs < rhs);
+        }
+
+        size_t Index() const noexcept {
+            return index_;
+        }
+
+    private:
+        template <typename OtherContainer, bool OTHER_CONST>
+        friend class IndexIterator;
+
+        ContainerRef* container_ = nullptr;
+        size_t index_ = 0;
+    };
+
+}  // namespace vector_detail
@@ -1,10 +1,42 @@
+// the tests check the counters of vector_stats.h and the trace of vector_trace.h too
+#define VECTOR_ENABLE_STATS
+#define VECTOR_ENABLE_TRACE
+
 #include "vector.h"
+#include "small_vector.h"
+#include "ring_vector.h"
+#include "soa_vector.h"
+#include "static_vector.h"
+#include "thread_cache.h"
+#include "vector_algorithms.h"
+#include "concurrent_vector.h"
+#include "cow_vector.h"
+#include "segmented_vector.h"
+#include "incremental_vector.h"
+#include "file_mapped_vector.h"
+#include "flat_map.h"
+#include "vector_serialization.h"
+#include "obj.h"
 
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 namespace {
 
     // "magic" number used to define if an object is alive
@@ -25,99 +57,129 @@ namespace {
         uint32_t cookie = DEFAULT_COOKIE;
     };
 
-    struct Obj {
-        Obj() {
-            if (default_construction_throw_countdown > 0) {
-                if (--default_construction_throw_countdown == 0) {
-                    throw std::runtime_error("Oops");
-                }
-            }
-            ++num_default_constructed;
+    // counts allocations made through it, instances with different ids are not equal
+    template <typename T>
+    struct TrackingAllocator {
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::false_type;
+        using propagate_on_container_swap = std::false_type;
+
+        explicit TrackingAllocator(int id = 0) noexcept
+            : id(id) {
         }
 
-        explicit Obj(int id)
-            : id(id)  //
-        {
-            ++num_constructed_with_id;
+        template <typename U>
+        TrackingAllocator(const TrackingAllocator<U>& other) noexcept
+            : id(other.id) {
         }
 
-        Obj(int id, std::string name)
-            : id(id)
-            , name(std::move(name))  
-        {
-            ++num_constructed_with_id_and_name;
+        T* allocate(size_t n) {
+            ++num_allocations;
+            return std::allocator<T>{}.allocate(n);
         }
 
-        Obj(const Obj& other)
-            : id(other.id)  
-        {
-            if (other.throw_on_copy) {
-                throw std::runtime_error("Oops");
-            }
-            ++num_copied;
+        void deallocate(T* p, size_t n) noexcept {
+            ++num_deallocations;
+            std::allocator<T>{}.deallocate(p, n);
         }
 
-        Obj(Obj&& other) noexcept
-            : id(other.id)  
-        {
-            ++num_moved;
+        bool operator==(const TrackingAllocator& other) const noexcept {
+            return id == other.id;
         }
 
-        Obj& operator=(const Obj& other) {
-            if (this != &other) {
-                id = other.id;
-                name = other.name;
-                ++num_assigned;
-            }
-            return *this;
+        bool operator!=(const TrackingAllocator& other) const noexcept {
+            return id != other.id;
         }
 
-        Obj& operator=(Obj&& other) noexcept {
-            id = other.id;
-            name = std::move(other.name);
-            ++num_move_assigned;
-            return *this;
+        static void ResetCounters() {
+            num_allocations = 0;
+            num_deallocations = 0;
         }
 
-        ~Obj() {
-            ++num_destroyed;
-            id = 0;
+        int id = 0;
+
+        static inline int num_allocations = 0;
+        static inline int num_deallocations = 0;
+    };
+
+    // counts moves and destructions, so relocation by memcpy is visible
+    struct RelocatableObj {
+        explicit RelocatableObj(int id) noexcept
+            : id(id) {
         }
 
-        static int GetAliveObjectCount() {
-            return num_default_constructed + num_copied + num_moved + num_constructed_with_id
-                + num_constructed_with_id_and_name - num_destroyed;
+        RelocatableObj(const RelocatableObj& other) noexcept
+            : id(other.id) {
+            ++num_copied;
+        }
+
+        RelocatableObj(RelocatableObj&& other) noexcept
+            : id(other.id) {
+            ++num_moved;
+        }
+
+        RelocatableObj& operator=(const RelocatableObj& other) = default;
+        RelocatableObj& operator=(RelocatableObj&& other) = default;
+
+        ~RelocatableObj() {
+            ++num_destroyed;
         }
 
         static void ResetCounters() {
-            default_construction_throw_countdown = 0;
-            num_default_constructed = 0;
             num_copied = 0;
             num_moved = 0;
             num_destroyed = 0;
-            num_constructed_with_id = 0;
-            num_constructed_with_id_and_name = 0;
-            num_assigned = 0;
-            num_move_assigned = 0;
         }
 
-        bool throw_on_copy = false;
         int id = 0;
-        std::string name;
 
-        static inline int default_construction_throw_countdown = 0;
-        static inline int num_default_constructed = 0;
-        static inline int num_constructed_with_id = 0;
-        static inline int num_constructed_with_id_and_name = 0;
         static inline int num_copied = 0;
         static inline int num_moved = 0;
         static inline int num_destroyed = 0;
-        static inline int num_assigned = 0;
-        static inline int num_move_assigned = 0;
+    };
+
+    // has no move operations, so it is copied where a vector moves; the copy that brings
+    // copy_throw_countdown to zero throws, whether it constructs or assigns
+    struct CopyOnlyObj {
+        explicit CopyOnlyObj(int id = 0) noexcept
+            : id(id) {
+            ++num_alive;
+        }
+
+        CopyOnlyObj(const CopyOnlyObj& other)
+            : id(other.id) {
+            CountCopy();
+            ++num_alive;
+        }
+
+        CopyOnlyObj& operator=(const CopyOnlyObj& other) {
+            CountCopy();
+            id = other.id;
+            return *this;
+        }
+
+        ~CopyOnlyObj() {
+            --num_alive;
+        }
+
+        static void CountCopy() {
+            if (copy_throw_countdown > 0 && --copy_throw_countdown == 0) {
+                throw std::runtime_error("Oops");
+            }
+        }
+
+        int id = 0;
+
+        static inline int copy_throw_countdown = 0;
+        static inline int num_alive = 0;
     };
 
 }  // namespace
 
+template <>
+struct IsTriviallyRelocatable<RelocatableObj> : std::true_type {
+};
+
 void Test1() {
     Obj::ResetCounters();
     const size_t SIZE = 100500;
@@ -431,7 +493,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v;
-        auto* pos = v.Emplace(v.end(), Obj{ 1 });
+        auto pos = v.Emplace(v.end(), Obj{ 1 });
         assert(v.Size() == 1);
         assert(v.Capacity() >= v.Size());
         assert(&*pos == &v[0]);
@@ -446,7 +508,7 @@ void Test6() {
         Obj::ResetCounters();
         Vector<Obj> v;
         v.Reserve(SIZE);
-        auto* pos = v.Emplace(v.end(), Obj{ 1 });
+        auto pos = v.Emplace(v.end(), Obj{ 1 });
         assert(v.Size() == 1);
         assert(v.Capacity() >= v.Size());
         assert(&*pos == &v[0]);
@@ -493,7 +555,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v{ SIZE };
-        auto* pos = v.Emplace(v.cbegin() + 1, ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + 1, ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(v.Capacity() == SIZE * 2);
         assert(&*pos == &v[1]);
@@ -509,7 +571,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v{ SIZE };
-        auto* pos = v.Emplace(v.cbegin() + v.Size(), ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + v.Size(), ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(v.Capacity() == SIZE * 2);
         assert(&*pos == &v[SIZE]);
@@ -528,7 +590,7 @@ void Test6() {
         v.Reserve(SIZE * 2);
         const int old_num_moved = Obj::num_moved;
         assert(v.Capacity() == SIZE * 2);
-        auto* pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(&*pos == &v[3]);
         assert(v[3].id == ID);
@@ -536,15 +598,16 @@ void Test6() {
         assert(Obj::num_copied == 0);
         assert(Obj::num_default_constructed == SIZE);
         assert(Obj::num_constructed_with_id_and_name == 1);
+        // the item is built in the gap although its constructor may throw, as Obj moves don't
         assert(Obj::num_moved == old_num_moved + 1);
-        assert(Obj::num_move_assigned == SIZE - 3);
+        assert(Obj::num_move_assigned == SIZE - 4);
         assert(Obj::num_assigned == 0);
     }
     {
         Obj::ResetCounters();
         Vector<Obj> v{ SIZE };
         v[2].id = ID;
-        auto* pos = v.Erase(v.cbegin() + 1);
+        auto pos = v.Erase(v.cbegin() + 1);
         assert((pos - v.begin()) == 1);
         assert(v.Size() == SIZE - 1);
         assert(v.Capacity() == SIZE);
@@ -557,87 +620,2209 @@ void Test6() {
     }
 }
 
-struct C {
-    C() noexcept {
-        ++def_ctor;
+void Test7() {
+    const size_t SIZE = 100;
+    const int ID = 42;
+    {
+        TrackingAllocator<Obj>::ResetCounters();
+        Obj::ResetCounters();
+        {
+            Vector<Obj, TrackingAllocator<Obj>> v(TrackingAllocator<Obj>{ 1 });
+            for (size_t i = 0; i < SIZE; ++i) {
+                v.PushBack(Obj{ ID });
+            }
+            assert(v.GetAllocator().id == 1);
+            assert(TrackingAllocator<Obj>::num_allocations > 0);
+
+            const auto v_copy(v);
+            assert(v_copy.GetAllocator().id == 1);
+            assert(v_copy.Size() == SIZE);
+        }
+        assert(TrackingAllocator<Obj>::num_allocations == TrackingAllocator<Obj>::num_deallocations);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        // allocators are not equal and don't propagate, so the elements have to be moved
+        TrackingAllocator<Obj>::ResetCounters();
+        Obj::ResetCounters();
+        {
+            Vector<Obj, TrackingAllocator<Obj>> v1(SIZE, TrackingAllocator<Obj>{ 1 });
+            Vector<Obj, TrackingAllocator<Obj>> v2(TrackingAllocator<Obj>{ 2 });
+            v1[0].id = ID;
+            v2 = std::move(v1);
+            assert(v2.GetAllocator().id == 2);
+            assert(v2.Size() == SIZE);
+            assert(v2[0].id == ID);
+            assert(Obj::num_moved == SIZE);
+
+            Vector<Obj, TrackingAllocator<Obj>> v3(std::move(v2), TrackingAllocator<Obj>{ 2 });
+            assert(v3.Size() == SIZE);
+            assert(v2.Size() == 0);
+            assert(Obj::num_moved == SIZE);
+        }
+        assert(TrackingAllocator<Obj>::num_allocations == TrackingAllocator<Obj>::num_deallocations);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v1(SIZE);
+        Vector<Obj> v2(SIZE / 2);
+        v2 = std::move(v1);
+        assert(v2.Size() == SIZE);
+        assert(Obj::GetAliveObjectCount() == SIZE);
+    }
+    {
+        std::pmr::monotonic_buffer_resource resource;
+        std::pmr::polymorphic_allocator<int> alloc(&resource);
+        Vector<int, std::pmr::polymorphic_allocator<int>> v(alloc);
+        for (int i = 0; i < ID; ++i) {
+            v.PushBack(i);
+        }
+        assert(v.GetAllocator().resource() == &resource);
+        assert(v[ID - 1] == ID - 1);
+
+        Vector<int, std::pmr::polymorphic_allocator<int>> v_copy(v);
+        assert(v_copy.GetAllocator().resource() == std::pmr::get_default_resource());
     }
-    C(const C& /*other*/) noexcept {
-        ++copy_ctor;
+}
+
+void Test8() {
+    const int SIZE = 100;
+    {
+        Vector<int> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.PushBack(i);
+        }
+        [[maybe_unused]] auto pos = v.Insert(v.cbegin() + 1, v[SIZE - 1]);
+        assert(pos == v.begin() + 1);
+        assert(v[1] == SIZE - 1);
+        assert(v[2] == 1);
+        [[maybe_unused]] auto next = v.Erase(v.cbegin());
+        assert(next == v.begin());
+        assert(v.Size() == SIZE);
+        assert(v[0] == SIZE - 1);
+        assert(v[SIZE - 1] == SIZE - 1);
     }
-    C(C&& /*other*/) noexcept {
-        ++move_ctor;
+    {
+        RelocatableObj::ResetCounters();
+        {
+            Vector<RelocatableObj> v;
+            for (int i = 0; i < SIZE; ++i) {
+                [[maybe_unused]] RelocatableObj& item = v.EmplaceBack(i);
+            }
+            v.Reserve(SIZE * 4);
+            assert(RelocatableObj::num_moved == 0);
+            assert(RelocatableObj::num_destroyed == 0);
+
+            // the argument refers to an element that is shifted by the insertion
+            auto pos = v.Insert(v.cbegin(), v[0]);
+            assert(pos->id == 0);
+            assert(v[1].id == 0);
+            assert(v[SIZE].id == SIZE - 1);
+            assert(RelocatableObj::num_copied == 1);
+
+            pos = v.Erase(v.cbegin() + 1);
+            assert(pos->id == 1);
+            assert(v.Size() == SIZE);
+            assert(RelocatableObj::num_moved == 0);
+            assert(RelocatableObj::num_destroyed == 1);
+        }
+        assert(RelocatableObj::num_destroyed == SIZE + 1);
     }
-    C& operator=(const C& other) noexcept {
-        if (this != &other) {
-            ++copy_assign;
+}
+
+void Test9() {
+    const int SIZE = 100'000;
+    {
+        Vector<int, MallocAllocator<int>> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.PushBack(i);
+        }
+        assert(v.Size() == SIZE);
+        for (int i = 0; i < SIZE; ++i) {
+            assert(v[i] == i);
         }
-        return *this;
+        v.Reserve(SIZE * 4);
+        assert(v.Capacity() == SIZE * 4);
+        assert(v[SIZE - 1] == SIZE - 1);
     }
-    C& operator=(C&& /*other*/) noexcept {
-        ++move_assign;
-        return *this;
+    {
+        Vector<int, MallocAllocator<int>> v(1);
+        v[0] = SIZE;
+        // the argument refers to the buffer that is reallocated
+        v.PushBack(v[0]);
+        assert(v[1] == SIZE);
+        auto pos = v.Insert(v.cbegin() + 1, v[0] + 1);
+        assert(v.Size() == 3);
+        assert(*pos == SIZE + 1);
+        assert(v[2] == SIZE);
     }
-    ~C() {
-        ++dtor;
+    {
+        RelocatableObj::ResetCounters();
+        {
+            Vector<RelocatableObj, MallocAllocator<RelocatableObj>> v;
+            for (int i = 0; i < SIZE; ++i) {
+                [[maybe_unused]] RelocatableObj& item = v.EmplaceBack(i);
+            }
+            assert(v[SIZE - 1].id == SIZE - 1);
+            assert(RelocatableObj::num_moved == 0);
+            assert(RelocatableObj::num_destroyed == 0);
+        }
+        assert(RelocatableObj::num_destroyed == SIZE);
     }
+}
+
+void Test10() {
+    const size_t INLINE_SIZE = 8;
+    const int ID = 42;
+    using namespace std::literals;
+    {
+        TrackingAllocator<Obj>::ResetCounters();
+        Obj::ResetCounters();
+        {
+            SmallVector<Obj, INLINE_SIZE, TrackingAllocator<Obj>> v;
+            assert(v.Capacity() == INLINE_SIZE);
+            for (size_t i = 0; i < INLINE_SIZE - 1; ++i) {
+                [[maybe_unused]] Obj& item = v.EmplaceBack(static_cast<int>(i));
+            }
+            auto pos = v.Emplace(v.cbegin() + 1, ID, "Ivan"s);
+            assert(pos->id == ID);
+            assert(v[2].id == 1);
+            const auto v_copy(v);
+            assert(v_copy.Size() == INLINE_SIZE);
+            assert(TrackingAllocator<Obj>::num_allocations == 0);
 
-    static void Reset() {
-        def_ctor = 0;
-        copy_ctor = 0;
-        move_ctor = 0;
-        copy_assign = 0;
-        move_assign = 0;
-        dtor = 0;
+            const Obj* inline_address = &v[0];
+            v.PushBack(Obj{ ID });
+            assert(TrackingAllocator<Obj>::num_allocations == 1);
+            assert(v.Size() == INLINE_SIZE + 1);
+            assert(v.Capacity() == INLINE_SIZE * 2);
+            assert(&v[0] != inline_address);
+            assert(v[1].id == ID);
+            assert(v[INLINE_SIZE - 1].id == static_cast<int>(INLINE_SIZE - 2));
+            assert(v[INLINE_SIZE].id == ID);
+        }
+        assert(TrackingAllocator<Obj>::num_allocations == TrackingAllocator<Obj>::num_deallocations);
+        assert(Obj::GetAliveObjectCount() == 0);
     }
+    {
+        Obj::ResetCounters();
+        {
+            SmallVector<Obj, INLINE_SIZE> small(INLINE_SIZE / 2);
+            small[0].id = ID;
+            SmallVector<Obj, INLINE_SIZE> large(INLINE_SIZE * 2);
+            large[0].id = ID + 1;
 
-    inline static size_t def_ctor = 0;
-    inline static size_t copy_ctor = 0;
-    inline static size_t move_ctor = 0;
-    inline static size_t copy_assign = 0;
-    inline static size_t move_assign = 0;
-    inline static size_t dtor = 0;
-};
+            SmallVector<Obj, INLINE_SIZE> moved_small(std::move(small));
+            assert(small.Size() == 0);
+            assert(moved_small.Size() == INLINE_SIZE / 2);
+            assert(moved_small[0].id == ID);
+
+            const Obj* large_address = &large[0];
+            SmallVector<Obj, INLINE_SIZE> moved_large(std::move(large));
+            assert(&moved_large[0] == large_address);
 
-void Dump() {
-    using namespace std;
-    cerr << "Def ctors: "sv << C::def_ctor              
-        << ", Copy ctors: "sv << C::copy_ctor          
-        << ", Move ctors: "sv << C::move_ctor          
-        << ", Copy assignments: "sv << C::copy_assign  
-        << ", Move assignments: "sv << C::move_assign  
-        << ", Dtors: "sv << C::dtor << endl;
+            moved_small.Swap(moved_large);
+            assert(moved_small.Size() == INLINE_SIZE * 2);
+            assert(moved_small[0].id == ID + 1);
+            assert(moved_large.Size() == INLINE_SIZE / 2);
+            assert(moved_large[0].id == ID);
+
+            moved_small = std::move(moved_large);
+            assert(moved_small.Size() == INLINE_SIZE / 2);
+            assert(moved_small[0].id == ID);
+            assert(Obj::GetAliveObjectCount() == INLINE_SIZE / 2);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, INLINE_SIZE> v(INLINE_SIZE);
+        try {
+            v[INLINE_SIZE / 2].throw_on_copy = true;
+            SmallVector<Obj, INLINE_SIZE> v_copy(v);
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == INLINE_SIZE);
+    }
 }
 
-void Benchmark() {
-    using namespace std;
-    try {
-        const size_t NUM = 10;
-        C c;
-        {
-            cerr << "std::vector:"sv << endl;
-            C::Reset();
-            vector<C> v(NUM);
-            Dump();
-            v.push_back(c);
+template <typename GrowthPolicy>
+std::vector<size_t> GetCapacities(size_t num_items) {
+    Vector<int, std::allocator<int>, GrowthPolicy> v;
+    std::vector<size_t> capacities;
+    for (size_t i = 0; i < num_items; ++i) {
+        v.PushBack(static_cast<int>(i));
+        if (capacities.empty() || capacities.back() != v.Capacity()) {
+            capacities.push_back(v.Capacity());
         }
-        Dump();
     }
-    catch (...) {
+    return capacities;
+}
+
+void Test11() {
+    const size_t PAGE_SIZE = 4096;
+    {
+        assert((GetCapacities<DoublingGrowth>(10) == std::vector<size_t>{ 1, 2, 4, 8, 16 }));
+        assert((GetCapacities<OneAndHalfGrowth>(10) == std::vector<size_t>{ 1, 2, 3, 4, 6, 9, 13 }));
+        assert((GetCapacities<GoldenRatioGrowth>(10) == std::vector<size_t>{ 1, 2, 3, 4, 6, 9, 14 }));
+        assert((GetCapacities<CappedGrowth<DoublingGrowth, 4 * sizeof(int)>>(20)
+            == std::vector<size_t>{ 1, 2, 4, 8, 12, 16, 20 }));
     }
-    try {
-        const size_t NUM = 10;
-        C c;
+    {
+        const size_t capacity = PageRoundedGrowth<>::NewCapacity(PAGE_SIZE, PAGE_SIZE + 1, 3);
+        assert(capacity >= PAGE_SIZE * 2);
+        assert(capacity * 3 % PAGE_SIZE < 3);
+        assert(PageRoundedGrowth<>::NewCapacity(10, 11, 4) == 20);
+
+        const size_t max_capacity = std::numeric_limits<size_t>::max() / 8;
+        assert(DoublingGrowth::NewCapacity(max_capacity - 1, max_capacity, 8) == max_capacity);
+        assert(OneAndHalfGrowth::NewCapacity(max_capacity - 1, max_capacity, 8) == max_capacity);
+    }
+    {
+        for (size_t capacity = 1; capacity < 1'000; ++capacity) {
+            const size_t new_capacity = SizeClassGrowth<>::NewCapacity(capacity, capacity + 1, 3);
+            assert(new_capacity >= capacity * 2);
+            assert(new_capacity * 3 <= MallocGoodSize(capacity * 2 * 3));
+        }
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj, std::allocator<Obj>, OneAndHalfGrowth> v(4);
+        v[3].throw_on_copy = true;
+        v.PushBack(Obj{ 1 });
+        assert(v.Capacity() == 6);
+        assert(Obj::num_copied == 0);
+        assert(Obj::GetAliveObjectCount() == 5);
+    }
+}
+
+void Test12() {
+    const size_t SIZE = 10;
+    const int ID = 42;
+    {
+        const Vector<int> v{ 1, 2, 3 };
+        assert(v.Size() == 3);
+        assert(v.Capacity() == 3);
+        assert(v[2] == 3);
+
+        std::istringstream input("4 5 6");
+        Vector<int> v_input(std::istream_iterator<int>(input), std::istream_iterator<int>{});
+        assert((std::vector<int>(v_input.begin(), v_input.end()) == std::vector<int>{ 4, 5, 6 }));
+
+        Vector<int> v_range(v.begin(), v.end());
+        v_range.Append({ 7, 8 });
+        auto pos = v_range.Insert(v_range.cbegin() + 1, v_input.begin(), v_input.end());
+        assert(pos == v_range.begin() + 1);
+        assert((std::vector<int>(v_range.begin(), v_range.end()) == std::vector<int>{ 1, 4, 5, 6, 2, 3, 7, 8 }));
+
+        std::istringstream end_input("9 10");
+        pos = v_range.Insert(v_range.cbegin() + 2, std::istream_iterator<int>(end_input), std::istream_iterator<int>{});
+        assert(*pos == 9);
+        assert((std::vector<int>(v_range.begin(), v_range.end()) == std::vector<int>{ 1, 4, 9, 10, 5, 6, 2, 3, 7, 8 }));
+
+        pos = v_range.Insert(v_range.cbegin(), 2, v_range[9]);
+        assert((std::vector<int>(v_range.begin(), v_range.end()) == std::vector<int>{ 8, 8, 1, 4, 9, 10, 5, 6, 2, 3, 7, 8 }));
+    }
+    {
+        // a single reallocation for a range of any length
+        TrackingAllocator<Obj>::ResetCounters();
+        Obj::ResetCounters();
+        const Vector<Obj> items(SIZE * 10);
+        Vector<Obj, TrackingAllocator<Obj>> v(SIZE);
+        assert(TrackingAllocator<Obj>::num_allocations == 1);
+        v.Append(items.begin(), items.end());
+        assert(TrackingAllocator<Obj>::num_allocations == 2);
+        assert(v.Size() == SIZE * 11);
+        assert(Obj::num_copied == SIZE * 10);
+        assert(Obj::num_moved == SIZE);
+    }
+    {
+        // the tail is shifted once: inside the capacity, with a short and a long tail
+        for (size_t index : { size_t{ 2 }, SIZE - 1 }) {
+            Obj::ResetCounters();
+            Vector<Obj> items(3);
+            items[0].id = ID;
+            Vector<Obj> v(SIZE);
+            v[index].id = ID + 1;
+            v.Reserve(SIZE * 2);
+            const int num_moved = Obj::num_moved;
+            const size_t num_allocations = GetVectorStats().allocations;
+            auto pos = v.Insert(v.cbegin() + index, items.begin(), items.end());
+            assert(pos->id == ID);
+            assert(v.Size() == SIZE + 3);
+            assert(v[index + 3].id == ID + 1);
+            // the copies are built in the gap without a buffer aside
+            assert(Obj::num_copied == 3);
+            assert(Obj::num_moved + Obj::num_move_assigned - num_moved == static_cast<int>(SIZE - index));
+            assert(GetVectorStats().allocations == num_allocations);
+            assert(Obj::GetAliveObjectCount() == SIZE + 6);
+        }
+        // the tail is moved back if building the items in the gap fails
+        for (size_t index : { size_t{ 2 }, SIZE - 1 }) {
+            Obj::ResetCounters();
+            Vector<Obj> v(SIZE);
+            for (size_t i = 0; i < SIZE; ++i) {
+                v[i].id = static_cast<int>(i);
+            }
+            v.Reserve(SIZE * 2);
+            Vector<Obj> items(3);
+            items[2].throw_on_copy = true;
+            try {
+                [[maybe_unused]] auto pos = v.Insert(v.cbegin() + index, items.begin(), items.end());
+                assert(false && "Exception is expected");
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == SIZE && Obj::GetAliveObjectCount() == SIZE + 3);
+            for (size_t i = 0; i < SIZE; ++i) {
+                assert(v[i].id == static_cast<int>(i));
+            }
+        }
+    }
+    {
+        // with spare capacity, copy-only items are built aside; nothing leaks whichever copy throws,
+        // the tail being longer or shorter than the inserted items
+        const std::vector<CopyOnlyObj> items(3, CopyOnlyObj{ ID });
+        for (size_t index : { size_t{ 2 }, SIZE - 1 }) {
+            for (int countdown = 1;; ++countdown) {
+                bool is_thrown = false;
+                {
+                    Vector<CopyOnlyObj> v(SIZE);
+                    v.Reserve(SIZE * 2);
+                    CopyOnlyObj::copy_throw_countdown = countdown;
+                    try {
+                        [[maybe_unused]] auto pos = v.Insert(v.cbegin() + index, items.begin(), items.end());
+                    }
+                    catch (const std::runtime_error&) {
+                        is_thrown = true;
+                    }
+                    CopyOnlyObj::copy_throw_countdown = 0;
+                    assert(v.Size() == (is_thrown ? SIZE : SIZE + 3));
+                    assert(CopyOnlyObj::num_alive == static_cast<int>(v.Size() + items.size()));
+                }
+                assert(CopyOnlyObj::num_alive == static_cast<int>(items.size()));
+                if (!is_thrown) {
+                    break;
+                }
+            }
+        }
+    }
+    {
+        // strong guarantee when the reallocation fails
+        Obj::ResetCounters();
+        Vector<Obj> items(3);
+        items[2].throw_on_copy = true;
+        Vector<Obj> v(SIZE);
+        v[0].id = ID;
+        try {
+            [[maybe_unused]] auto pos = v.Insert(v.cbegin() + 1, items.begin(), items.end());
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() == SIZE);
+        assert(v[0].id == ID);
+        assert(Obj::GetAliveObjectCount() == SIZE + 3);
+    }
+    {
+        Vector<int> v{ 1, 2, 3, 4, 5 };
+        v.Reserve(SIZE);
+        const Vector<int> items{ 6, 7 };
+        [[maybe_unused]] auto pos = v.Insert(v.cbegin() + 1, items.begin(), items.end());
+        assert(pos == v.begin() + 1);
+        assert(v.Capacity() == SIZE);
+        assert((std::vector<int>(v.begin(), v.end()) == std::vector<int>{ 1, 6, 7, 2, 3, 4, 5 }));
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> items(SIZE);
+        Vector<Obj> v(SIZE / 2);
+        v.Reserve(SIZE * 2);
+        v.Assign(items.begin(), items.end());
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() == SIZE * 2);
+        assert(Obj::num_assigned == SIZE / 2);
+        assert(Obj::num_copied == SIZE / 2);
+
+        v.Assign(SIZE / 2, Obj{ ID });
+        assert(v.Size() == SIZE / 2);
+        assert(v[0].id == ID);
+        assert(Obj::GetAliveObjectCount() == SIZE + SIZE / 2);
+
+        v.Assign(SIZE * 3, v[0]);
+        assert(v.Size() == SIZE * 3);
+        assert(v[SIZE * 3 - 1].id == ID);
+
+        Vector<int> ints;
+        ints.Assign({ 1, 2 });
+        assert(ints.Size() == 2);
+    }
+}
+
+void Test13() {
+    const int SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        for (int i = 0; i < SIZE; ++i) {
+            v[i].id = i;
+        }
+        auto pos = v.Erase(v.cbegin() + 10, v.cbegin() + 20);
+        assert(pos->id == 20);
+        assert(v.Size() == SIZE - 10);
+        assert(Obj::num_move_assigned == SIZE - 20);
+        assert(Obj::GetAliveObjectCount() == SIZE - 10);
+
+        pos = v.Erase(v.cbegin() + 5, v.cbegin() + 5);
+        assert(pos->id == 5);
+        assert(v.Size() == SIZE - 10);
+
+        Obj::ResetCounters();
+        const size_t num_removed = v.EraseIf([](const Obj& obj) {
+            return obj.id % 2 == 0;
+        });
+        assert(num_removed == (SIZE - 10) / 2);
+        assert(v.Size() == (SIZE - 10) / 2);
+        assert(std::all_of(v.begin(), v.end(), [](const Obj& obj) {
+            return obj.id % 2 == 1;
+        }));
+        assert(Obj::num_destroyed == (SIZE - 10) / 2);
+        assert(Obj::num_move_assigned <= SIZE - 10);
+    }
+    {
+        RelocatableObj::ResetCounters();
         {
-            cerr << "Vector:"sv << endl;
-            C::Reset();
-            Vector<C> v(NUM);
-            Dump();
-            v.PushBack(c);
+            Vector<RelocatableObj> v;
+            for (int i = 0; i < SIZE; ++i) {
+                [[maybe_unused]] RelocatableObj& item = v.EmplaceBack(i);
+            }
+            v.Erase(v.cbegin(), v.cbegin() + 10);
+            assert(v[0].id == 10);
+            assert(RelocatableObj::num_destroyed == 10);
+
+            assert(v.EraseIf([](const RelocatableObj& obj) {
+                return obj.id % 3 == 0;
+            }) == 30);
+            assert(v.Size() == 60);
+            assert(v[0].id == 10);
+            assert(v[1].id == 11);
+            assert(v[2].id == 13);
+            assert(RelocatableObj::num_destroyed == 40);
+            assert(RelocatableObj::num_moved == 0);
+
+            // an exception leaves the kept and the unchecked items
+            try {
+                v.EraseIf([](const RelocatableObj& obj) {
+                    if (obj.id > 50) {
+                        throw std::runtime_error("Oops");
+                    }
+                    return obj.id < 20;
+                });
+                assert(false && "Exception is expected");
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(v[0].id == 20);
+            assert(v.Size() + RelocatableObj::num_destroyed == SIZE);
+            assert(std::is_sorted(v.begin(), v.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.id < rhs.id;
+            }));
         }
-        Dump();
+        assert(RelocatableObj::num_destroyed == SIZE);
+    }
+}
+
+void Test14() {
+    const size_t SIZE = 100;
+    const int MAGIC = 42;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE, DEFAULT_INIT);
+        assert(v.Size() == SIZE);
+        assert(Obj::num_default_constructed == SIZE);
+        v.ResizeDefaultInit(SIZE / 2);
+        assert(Obj::GetAliveObjectCount() == SIZE / 2);
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(v.Size() == SIZE * 2);
+        assert(v.Capacity() == SIZE * 2);
+        assert(Obj::GetAliveObjectCount() == SIZE * 2);
+    }
+    {
+        Vector<int> v(SIZE, DEFAULT_INIT);
+        std::fill(v.begin(), v.end(), MAGIC);
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(v.Size() == SIZE * 2);
+        assert(v[SIZE - 1] == MAGIC);
+    }
+    {
+        Vector<char> v{ 'a', 'b' };
+        const std::string_view text = "cdef";
+        v.ResizeAndOverwrite(SIZE, [&text](char* data, size_t count) {
+            assert(count == SIZE);
+            // like a short read into the buffer
+            std::copy(text.begin(), text.end(), data + 2);
+            return text.size() + 2;
+        });
+        assert(v.Size() == text.size() + 2);
+        assert(v.Capacity() == SIZE);
+        assert(std::string_view(&v[0], v.Size()) == "abcdef");
+
+        v.ResizeAndOverwrite(1, [](char*, size_t) {
+            return size_t{ 1 };
+        });
+        assert(v.Size() == 1);
+        assert(v[0] == 'a');
     }
-    catch (...) {
+}
+
+void Test15() {
+    const size_t SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        v.ShrinkToFit();
+        assert(v.Capacity() == SIZE);
+        assert(Obj::num_moved == SIZE * 2);
+
+        v.Clear();
+        assert(v.Size() == 0);
+        assert(v.Capacity() == SIZE);
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        v.PushBack(Obj{ 1 });
+        v.ClearAndRelease();
+        assert(v.Capacity() == 0);
+        assert(v.begin() == nullptr);
+        assert(Obj::GetAliveObjectCount() == 0);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0);
     }
+    {
+        // the vector stays untouched if shrinking fails
+        struct CopyOnly {
+            CopyOnly() = default;
+            CopyOnly(const CopyOnly& other) {
+                if (other.throw_on_copy) {
+                    throw std::runtime_error("Oops");
+                }
+            }
+            bool throw_on_copy = false;
+        };
+        Vector<CopyOnly> w(SIZE);
+        w.Reserve(SIZE * 2);
+        w[SIZE / 2].throw_on_copy = true;
+        try {
+            w.ShrinkToFit();
+            assert(false && "Exception is expected");
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(w.Size() == SIZE);
+        assert(w.Capacity() == SIZE * 2);
+    }
+    {
+        TrackingAllocator<int>::ResetCounters();
+        Vector<int, TrackingAllocator<int>, AutoShrinkGrowth<>> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        assert(v.Capacity() == 128);
+        const int num_allocations = TrackingAllocator<int>::num_allocations;
+        while (v.Size() > 32) {
+            v.PopBack();
+        }
+        assert(v.Capacity() == 128);
+        v.PopBack();
+        assert(v.Size() == 31);
+        assert(v.Capacity() == 62);
+        assert(v[30] == 30);
+
+        // hysteresis: no reallocation when going back and forth across the threshold
+        v.PushBack(31);
+        v.PopBack();
+        assert(TrackingAllocator<int>::num_allocations == num_allocations + 1);
+
+        v.Erase(v.cbegin(), v.cbegin() + 20);
+        assert(v.Size() == 11);
+        assert(v.Capacity() == 22);
+        assert(v[0] == 20);
+
+        v.Resize(1);
+        assert(v.Capacity() == 2);
+    }
+    {
+        SmallVector<int, 4, std::allocator<int>, AutoShrinkGrowth<>> v{ 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        assert(v.Capacity() == 9);
+        v.Resize(1);
+        assert(v.Capacity() == 4);
+        assert(v[0] == 1);
+
+        SmallVector<int, 4> w{ 1, 2, 3, 4, 5 };
+        w.Resize(3);
+        w.ShrinkToFit();
+        assert(w.Capacity() == 4);
+        assert(w[2] == 3);
+        w.ClearAndRelease();
+        assert(w.Capacity() == 4);
+    }
+}
+
+VectorStats exported_stats;
+
+void Test16() {
+    const size_t SIZE = 10;
+    {
+        ResetVectorStats();
+        Vector<Obj> v(SIZE);
+        v.PushBack(Obj{ 1 });
+        v.Reserve(SIZE * 4);
+        const VectorStats stats = GetVectorStats();
+        assert(stats.allocations == 3);
+        assert(stats.bytes_allocated == (SIZE + SIZE * 2 + SIZE * 4) * sizeof(Obj));
+        assert(stats.reallocations == 2);
+        assert(stats.items_moved == SIZE + SIZE + 1);
+        assert(stats.items_copied == 0);
+        assert(stats.peak_capacity_bytes == SIZE * 4 * sizeof(Obj));
+    }
+    {
+        struct ThrowingMove {
+            ThrowingMove() = default;
+            ThrowingMove(const ThrowingMove&) = default;
+            ThrowingMove(ThrowingMove&&) noexcept(false) {
+            }
+        };
+        ResetVectorStats();
+        Vector<ThrowingMove> v(SIZE);
+        v.Reserve(SIZE * 2);
+        Vector<int> ints(SIZE);
+        ints.Reserve(SIZE * 2);
+        const VectorStats stats = GetVectorStats();
+        assert(stats.items_copied == SIZE);
+        assert(stats.items_moved == 0);
+        assert(stats.items_relocated == SIZE);
+        assert(stats.reallocations == 2);
+    }
+    {
+        SetVectorStatsExporter([](const VectorStats& stats) {
+            exported_stats = stats;
+        });
+        std::thread worker([] {
+            Vector<int> v;
+            for (int i = 0; i < 4; ++i) {
+                v.PushBack(i);
+            }
+        });
+        worker.join();
+        SetVectorStatsExporter(nullptr);
+        assert(exported_stats.allocations == 3);
+        assert(exported_stats.reallocations == 3);
+        assert(exported_stats.items_relocated == 1 + 2);
+    }
+}
+
+void Test17() {
+    const size_t SIZE = 100;
+    auto is_aligned = [](const void* ptr, size_t alignment) {
+        return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+    };
+    {
+        Vector<float, AlignedAllocator<float, 64>> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<float>(i));
+            assert(is_aligned(v.begin(), 64));
+        }
+        assert(v.Capacity() == 128);
+    }
+    {
+        Vector<char, AlignedAllocator<char, CACHE_LINE_SIZE, true>> v;
+        v.Reserve(10);
+        assert(v.Capacity() == CACHE_LINE_SIZE);
+        v.Resize(CACHE_LINE_SIZE + 1);
+        assert(v.Capacity() == CACHE_LINE_SIZE * 2);
+
+        Vector<int, AlignedAllocator<int, CACHE_LINE_SIZE, true>> ints;
+        for (size_t i = 0; i < SIZE; ++i) {
+            ints.PushBack(static_cast<int>(i));
+            assert(ints.Capacity() * sizeof(int) % CACHE_LINE_SIZE == 0);
+            assert(is_aligned(ints.begin(), CACHE_LINE_SIZE));
+        }
+        assert(ints[SIZE - 1] == static_cast<int>(SIZE - 1));
+    }
+    {
+        // the default allocator takes the alignment of over-aligned types into account
+        struct alignas(128) Block {
+            char bytes[16];
+        };
+        Vector<Block> v(3);
+        v.PushBack(Block{});
+        assert(is_aligned(v.begin(), 128));
+
+        SmallVector<Block, 2> small(2);
+        assert(is_aligned(small.begin(), 128));
+    }
+}
+
+template <typename T>
+void CheckBulkOperations(size_t size) {
+    Vector<T> v(size);
+    for (size_t i = 0; i < size; ++i) {
+        v[i] = static_cast<T>(i % 7);
+    }
+    assert(Count(v, T(3)) == static_cast<size_t>(std::count(v.begin(), v.end(), T(3))));
+    assert(Find(v, T(5)) == std::find(v.begin(), v.end(), T(5)));
+    assert(Find(v, T(100)) == v.end());
+    assert(Reduce(v) == std::accumulate(v.begin(), v.end(), T(0)));
+    assert(Reduce(v, T(10), std::plus<T>{}) == std::accumulate(v.begin(), v.end(), T(10)));
+    assert(Reduce(v, T(3), Minimum{}) == (size == 0 ? T(3) : T(0)));
+    assert(Reduce(v, T(-1), Maximum{}) == (size == 0 ? T(-1) : static_cast<T>(std::min<size_t>(size - 1, 6))));
+    // items of the tail are found too
+    if (size != 0) {
+        v[size - 1] = T(-5);
+        assert(Find(v, T(-5)) == v.end() - 1);
+        assert(Reduce(v, T(0), Minimum{}) == T(-5));
+    }
+
+    Vector<T> doubled;
+    Transform(v, doubled, [](T x) {
+        return x * 2 + 1;
+    });
+    assert(doubled.Size() == size);
+    Transform(v, [](T x) {
+        return x * 2 + 1;
+    });
+    assert(std::equal(v.begin(), v.end(), doubled.begin(), doubled.end()));
+
+    Fill(v, T(4));
+    assert(Count(v, T(4)) == size);
+}
+
+void Test18() {
+    const SimdLevel supported = GetSupportedSimdLevel();
+    for (SimdLevel level : { SimdLevel::SCALAR, SimdLevel::VECTOR_128, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+        SetSimdLevel(level);
+        assert(GetSimdLevel() == std::min(level, supported));
+        // the sizes cover the empty vector, a tail only and several blocks of every vector width
+        for (size_t size : { 0, 1, 7, 16, 33, 100, 1001 }) {
+            CheckBulkOperations<int>(size);
+            CheckBulkOperations<float>(size);
+            CheckBulkOperations<double>(size);
+        }
+    }
+    SetSimdLevel(supported);
+    {
+        // other item types and operations use the generic loops
+        Vector<std::string> strings{ "a", "b", "c" };
+        assert(Reduce(strings, std::string{}, std::plus<std::string>{}) == "abc");
+        assert(Find(strings, std::string("b")) == strings.begin() + 1);
+        Transform(strings, [](const std::string& s) {
+            return s + s;
+        });
+        assert(strings[2] == "cc");
+
+        Vector<int> ints{ 1, 2, 3, 4 };
+        assert(Reduce(ints, 1, std::multiplies<>{}) == 24);
+    }
+}
+
+// item for the parallel tests, its counters may be changed by several threads
+struct ParallelObj {
+    ParallelObj() {
+        Construct();
+    }
+
+    ParallelObj(const ParallelObj& other)
+        : value(other.value) {
+        Construct();
+    }
+
+    ParallelObj(ParallelObj&& other) noexcept
+        : value(other.value) {
+        ++num_alive;
+    }
+
+    ~ParallelObj() {
+        --num_alive;
+    }
+
+    void Construct() {
+        if (--constructions_before_throw == 0) {
+            throw std::runtime_error("Oops");
+        }
+        ++num_alive;
+        std::lock_guard guard(threads_mutex);
+        threads.insert(std::this_thread::get_id());
+    }
+
+    int value = 1;
+
+    static inline std::atomic<int> num_alive = 0;
+    static inline std::atomic<int> constructions_before_throw = 0;
+    static inline std::mutex threads_mutex;
+    static inline std::set<std::thread::id> threads;
+};
+
+void Test19() {
+    const size_t SIZE = 1000;
+    const size_t NUM_THREADS = 4;
+    SetVectorParallelism(SIZE * sizeof(ParallelObj) / NUM_THREADS, NUM_THREADS);
+    {
+        Vector<ParallelObj> v(SIZE);
+        assert(ParallelObj::num_alive == static_cast<int>(SIZE));
+        assert(ParallelObj::threads.size() == NUM_THREADS);
+
+        ParallelObj::threads.clear();
+        Vector<ParallelObj> copy(v);
+        assert(ParallelObj::threads.size() == NUM_THREADS);
+        assert(ParallelObj::num_alive == static_cast<int>(SIZE * 2));
+
+        v.Reserve(SIZE * 2);
+        assert(ParallelObj::num_alive == static_cast<int>(SIZE * 2));
+        copy.Clear();
+        assert(ParallelObj::num_alive == static_cast<int>(SIZE));
+    }
+    assert(ParallelObj::num_alive == 0);
+    {
+        // the chunks built by the other threads are destroyed
+        ParallelObj::constructions_before_throw = SIZE / 2;
+        try {
+            Vector<ParallelObj> v(SIZE);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(ParallelObj::num_alive == 0);
+    }
+    {
+        Vector<int> v(SIZE);
+        std::iota(v.begin(), v.end(), 0);
+        Vector<int> copy(v);
+        v.Reserve(SIZE * 10);
+        assert(std::equal(v.begin(), v.end(), copy.begin(), copy.end()));
+    }
+    SetVectorParallelism(std::numeric_limits<size_t>::max());
+    {
+        ParallelObj::threads.clear();
+        Vector<ParallelObj> v(SIZE);
+        assert(ParallelObj::threads.size() == 1);
+    }
+}
+
+void Test20() {
+    const int NUM_THREADS = 4;
+    const int ITEMS_PER_THREAD = 10000;
+    {
+        ConcurrentVector<std::pair<int, int>> v;
+        std::vector<std::thread> writers;
+        for (int t = 0; t < NUM_THREADS; ++t) {
+            writers.emplace_back([&v, t] {
+                for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                    v.EmplaceBack(t, i);
+                }
+            });
+        }
+        // every item of a snapshot taken during the appends is constructed
+        size_t last_size = 0;
+        while (last_size < NUM_THREADS * ITEMS_PER_THREAD) {
+            const auto snapshot = v.GetSnapshot();
+            assert(snapshot.Size() >= last_size);
+            for (size_t i = last_size; i < snapshot.Size(); ++i) {
+                assert(snapshot[i].first >= 0 && snapshot[i].first < NUM_THREADS);
+                assert(snapshot[i].second >= 0 && snapshot[i].second < ITEMS_PER_THREAD);
+            }
+            last_size = snapshot.Size();
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+
+        // the items of one thread keep their order
+        std::vector<int> next(NUM_THREADS, 0);
+        for (const auto& [thread, item] : v.GetSnapshot()) {
+            assert(item == next[thread]);
+            ++next[thread];
+        }
+        assert(v.Size() == NUM_THREADS * ITEMS_PER_THREAD);
+    }
+    {
+        // references stay valid while the vector grows
+        ConcurrentVector<std::string> v;
+        std::string& first = v.EmplaceBack("first");
+        const std::string* first_address = &first;
+        for (int i = 0; i < 1000; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+        assert(&v[0] == first_address && first == "first");
+        assert(v[1000] == "999");
+    }
+    {
+        // a throwing constructor doesn't take a slot
+        Obj::ResetCounters();
+        ConcurrentVector<Obj> v;
+        v.EmplaceBack();
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.EmplaceBack();
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        v.EmplaceBack(2);
+        assert(v.Size() == 2 && v[1].id == 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // a failed allocation of a segment doesn't take a slot, later appends are published
+        struct FailingResource : std::pmr::memory_resource {
+            void* do_allocate(size_t bytes, size_t alignment) override {
+                if (fail) {
+                    throw std::bad_alloc();
+                }
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                return this == &other;
+            }
+
+            bool fail = false;
+        };
+        FailingResource resource;
+        ConcurrentVector<int, std::pmr::polymorphic_allocator<int>> v(&resource);
+        // the first segment holds 32 items
+        for (int i = 0; i < 32; ++i) {
+            v.PushBack(i);
+        }
+        resource.fail = true;
+        try {
+            v.PushBack(32);
+            assert(false);
+        }
+        catch (const std::bad_alloc&) {
+        }
+        resource.fail = false;
+        v.PushBack(32);
+        assert(v.Size() == 33 && v.GetSnapshot()[32] == 32);
+    }
+    {
+        // the segments and their ready flags come from the allocator of the vector
+        struct CountingResource : std::pmr::memory_resource {
+            void* do_allocate(size_t bytes, size_t alignment) override {
+                ++num_allocations;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+                ++num_deallocations;
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                return this == &other;
+            }
+
+            int num_allocations = 0;
+            int num_deallocations = 0;
+        };
+        CountingResource resource;
+        {
+            ConcurrentVector<int, std::pmr::polymorphic_allocator<int>> v(&resource);
+            v.PushBack(0);
+            // the segment, its items and its ready flags
+            assert(resource.num_allocations == 3);
+            for (int i = 1; i < 33; ++i) {
+                v.PushBack(i);
+            }
+            assert(resource.num_allocations == 6);
+        }
+        assert(resource.num_deallocations == resource.num_allocations);
+    }
+}
+
+void Test21() {
+    const size_t SIZE = 1000;
+    {
+        SegmentedVector<int> v;
+        v.PushBack(0);
+        const int* first = &v[0];
+        for (size_t i = 1; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        // the items never move
+        assert(first == &v[0]);
+        assert(v.Size() == SIZE && v.Capacity() >= SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i] == static_cast<int>(i));
+        }
+        assert(std::accumulate(v.begin(), v.end(), 0) == static_cast<int>(SIZE * (SIZE - 1) / 2));
+        assert(v.end() - v.begin() == static_cast<std::ptrdiff_t>(SIZE));
+        assert(*(v.begin() + 500) == 500 && *(v.end() - 1) == static_cast<int>(SIZE - 1));
+        auto it = std::lower_bound(v.begin(), v.end(), 777);
+        assert(it - v.begin() == 777);
+
+        v.Erase(v.begin() + 1, v.begin() + 11);
+        assert(v.Size() == SIZE - 10 && v[1] == 11);
+        v.Insert(v.begin() + 1, 1);
+        assert(v[1] == 1 && v[2] == 11 && v.Size() == SIZE - 9);
+
+        SegmentedVector<int> copy(v);
+        assert(std::equal(v.begin(), v.end(), copy.begin(), copy.end()));
+        v.Resize(10);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 16 && v[9] == 18);
+        copy = std::move(v);
+        assert(copy.Size() == 10 && v.Size() == 0);
+    }
+    {
+        // copy assignment allocates the blocks with the allocator of the target, not with the one
+        // select_on_container_copy_construction gives, which is the default resource for pmr
+        std::pmr::monotonic_buffer_resource first_resource;
+        std::pmr::monotonic_buffer_resource second_resource;
+        SegmentedVector<int, std::pmr::polymorphic_allocator<int>> first(&first_resource);
+        SegmentedVector<int, std::pmr::polymorphic_allocator<int>> second(&second_resource);
+        for (int i = 0; i < 100; ++i) {
+            first.PushBack(i);
+        }
+        second.PushBack(-1);
+        std::pmr::memory_resource* default_resource = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+        second = first;
+        std::pmr::set_default_resource(default_resource);
+        assert(second.GetAllocator().resource() == &second_resource);
+        assert(second.Size() == 100 && second[99] == 99);
+    }
+    {
+        // appends don't move items, so even a payload without a move constructor may be used
+        struct Pinned {
+            explicit Pinned(int value)
+                : value(value) {
+            }
+            Pinned(const Pinned&) = delete;
+            Pinned& operator=(const Pinned&) = delete;
+            int value;
+        };
+        SegmentedVector<Pinned> pinned;
+        for (int i = 0; i < 100; ++i) {
+            pinned.EmplaceBack(i);
+        }
+        assert(pinned[99].value == 99);
+    }
+    {
+        Obj::ResetCounters();
+        SegmentedVector<Obj> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i));
+        }
+        // an argument that refers to an item stays valid during the growth
+        v.EmplaceBack(v[0]);
+        assert(v[SIZE].id == 0);
+        assert(Obj::num_moved == 0 && Obj::num_copied == 1);
+
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.EmplaceBack();
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE + 1);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test22() {
+    {
+        IncrementalVector<std::string> v;
+        for (int i = 0; i < 16; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+        assert(v.Capacity() == 16 && !v.IsMigrating());
+        // the growth moves only MIGRATION_STEP items, the others are found in the old buffer
+        v.PushBack("16");
+        assert(v.Capacity() == 32 && v.IsMigrating());
+        for (int i = 0; i <= 16; ++i) {
+            assert(v[i] == std::to_string(i));
+        }
+        // the argument may be an item of the old buffer
+        v.PushBack(v[15]);
+        assert(v[17] == "15");
+        for (int i = 18; i < 24; ++i) {
+            v.PushBack(std::to_string(i));
+        }
+        assert(!v.IsMigrating());
+        assert(std::equal(v.begin(), v.begin() + 17, v.Data()));
+
+        IncrementalVector<std::string> copy(v);
+        assert(std::equal(v.begin(), v.end(), copy.begin(), copy.end()));
+    }
+    {
+        // a growth by less than 1 + 1 / MIGRATION_STEP finishes the last migration first,
+        // the argument may be an item that it moves
+        IncrementalVector<std::string, std::allocator<std::string>, ScaledGrowth<5, 4>> v;
+        size_t old_size = 0;
+        while (v.Size() != v.Capacity() || !v.IsMigrating()) {
+            if (v.Size() == v.Capacity()) {
+                old_size = v.Size();
+            }
+            v.PushBack(std::string(32, static_cast<char>('a' + v.Size() % 26)));
+        }
+        const std::string last_old_item = v[old_size - 1];
+        v.PushBack(v[old_size - 1]);
+        assert(v[v.Size() - 1] == last_old_item && v[old_size - 1] == last_old_item);
+    }
+    {
+        ResetVectorStats();
+        IncrementalVector<int> v;
+        const size_t SIZE = 600;
+        for (size_t i = 0; i < SIZE; ++i) {
+            const size_t relocated_before = GetVectorStats().items_relocated;
+            v.PushBack(static_cast<int>(i));
+            // no push relocates more than MIGRATION_STEP items
+            assert(GetVectorStats().items_relocated - relocated_before <= 2);
+        }
+        assert(v.IsMigrating());
+
+        // pops during a migration shrink the part in the old buffer
+        while (v.Size() > 300) {
+            v.PopBack();
+        }
+        assert(!v.IsMigrating());
+        for (size_t i = 0; i < v.Size(); ++i) {
+            assert(v[i] == static_cast<int>(i));
+        }
+        assert(std::accumulate(v.begin(), v.end(), 0) == 299 * 300 / 2);
+
+        v.Reserve(SIZE * 4);
+        assert(v.Capacity() == SIZE * 4 && v[299] == 299);
+    }
+    {
+        Obj::ResetCounters();
+        IncrementalVector<Obj> v;
+        for (int i = 0; i < 100; ++i) {
+            v.PushBack(Obj(i));
+        }
+        assert(v[70].id == 70);
+        v.Clear();
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        // a vector in the middle of a migration is moved item by item to a vector on another resource
+        std::pmr::monotonic_buffer_resource first_resource;
+        std::pmr::monotonic_buffer_resource second_resource;
+        using PmrVector = IncrementalVector<int, std::pmr::polymorphic_allocator<int>>;
+        PmrVector first(&first_resource);
+        for (int i = 0; i < 17; ++i) {
+            first.PushBack(i);
+        }
+        assert(first.IsMigrating());
+        PmrVector second(&second_resource);
+        second.PushBack(-1);
+        second = std::move(first);
+        assert(second.GetAllocator().resource() == &second_resource && !second.IsMigrating());
+        assert(second.Size() == 17 && second[16] == 16 && first.Size() == 0);
+
+        PmrVector third(&first_resource);
+        third = second;
+        assert(third.GetAllocator().resource() == &first_resource && third[10] == 10);
+        // equal allocators let the buffers be stolen along with the migration state
+        third.PushBack(17);
+        PmrVector fourth(&first_resource);
+        fourth = std::move(third);
+        assert(fourth.IsMigrating() && fourth.Size() == 18 && fourth[17] == 17 && third.Size() == 0);
+    }
+}
+
+void Test23() {
+    {
+        Vector<uint64_t, MmapAllocator<uint64_t>> v;
+        v.PushBack(1);
+        // the capacity fills the page
+        assert(v.Capacity() == vector_detail::PageSize() / sizeof(uint64_t));
+        const size_t size = v.Capacity() * 10;
+        for (size_t i = 1; i < size; ++i) {
+            v.PushBack(i + 1);
+        }
+        v.Reserve(size * 100);
+        assert(v.Capacity() == size * 100);
+        for (size_t i = 0; i < size; ++i) {
+            assert(v[i] == i + 1);
+        }
+        v.ShrinkToFit();
+        assert(v.Capacity() == size && v[size - 1] == size);
+
+        Vector<int, MmapAllocator<int, true>> huge(10);
+        assert(huge.Capacity() == vector_detail::HUGE_PAGE_SIZE / sizeof(int));
+        huge.Resize(huge.Capacity());
+        huge.PushBack(1);
+        assert(huge.Capacity() == vector_detail::HUGE_PAGE_SIZE * 2 / sizeof(int) && huge[10] == 0);
+    }
+    const std::string path = (std::filesystem::temp_directory_path() / "file_mapped_vector_test.bin").string();
+    const size_t SIZE = 100000;
+    {
+        auto v = FileMappedVector<uint64_t>::Create(path);
+        assert(v.Size() == 0 && v.Capacity() > 0);
+        for (uint64_t i = 0; i < SIZE; ++i) {
+            v.PushBack(i * 3);
+        }
+        v.EmplaceBack(v[0]);
+        v.Sync();
+    }
+    {
+        // the items are back without reading them
+        auto v = FileMappedVector<uint64_t>::Open(path);
+        assert(v.Size() == SIZE + 1);
+        assert(v[SIZE - 1] == (SIZE - 1) * 3 && v[SIZE] == 0);
+        v.PopBack();
+        v.Resize(SIZE + 10);
+        assert(v[SIZE + 9] == 0);
+        assert(std::accumulate(v.begin(), v.begin() + 10, uint64_t{ 0 }) == 135);
+
+        auto moved = std::move(v);
+        moved.Clear();
+        assert(moved.Size() == 0 && moved.Capacity() >= SIZE);
+    }
+    {
+        try {
+            auto v = FileMappedVector<uint32_t>::Open(path);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        try {
+            auto v = FileMappedVector<uint32_t>::Open(path + ".missing");
+            assert(false);
+        }
+        catch (const std::system_error&) {
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+void Test24() {
+    struct Point {
+        double x;
+        double y;
+    };
+    Vector<Point> points;
+    for (int i = 0; i < 1000; ++i) {
+        points.PushBack({ static_cast<double>(i), -static_cast<double>(i) });
+    }
+    {
+        std::vector<unsigned char> bytes(SerializedSize(points));
+        SerializeVector(points, bytes.data());
+        const VectorView<Point> view = ViewSerializedVector<Point>(bytes.data(), bytes.size());
+        assert(view.Size() == points.Size());
+        // the view points into the buffer
+        assert(static_cast<const void*>(view.Data()) == bytes.data() + sizeof(SerializedVectorHeader));
+        assert(view[999].x == 999 && view[999].y == -999);
+
+        try {
+            ViewSerializedVector<Point>(bytes.data(), bytes.size() - 1);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        try {
+            ViewSerializedVector<int>(bytes.data(), bytes.size());
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+    {
+        const std::string path = (std::filesystem::temp_directory_path() / "serialized_vector_test.bin").string();
+        const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        assert(fd != -1);
+        WriteVector(fd, points);
+        WriteVector(fd, Vector<Point>{});
+        assert(static_cast<size_t>(lseek(fd, 0, SEEK_CUR)) == SerializedSize(points) + sizeof(SerializedVectorHeader));
+
+        lseek(fd, 0, SEEK_SET);
+        Vector<Point> read_points{ { 1, 1 } };
+        ReadVector(fd, read_points);
+        assert(read_points.Size() == points.Size() && read_points[500].x == 500);
+        ReadVector(fd, read_points);
+        assert(read_points.Size() == 0);
+        try {
+            ReadVector(fd, read_points);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        // a header of other items drops the old ones too
+        lseek(fd, 0, SEEK_SET);
+        Vector<int> ints{ 1, 2, 3 };
+        try {
+            ReadVector(fd, ints);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(ints.Size() == 0);
+
+        // a corrupt header with a huge size: nothing is allocated beyond the limit,
+        // and without one the buffer grows only with the items that arrive
+        lseek(fd, 0, SEEK_SET);
+        SerializedVectorHeader header;
+        [[maybe_unused]] const ssize_t header_read = read(fd, &header, sizeof(header));
+        assert(header_read == sizeof(header));
+        header.size = uint64_t{ 1 } << 40;
+        [[maybe_unused]] const ssize_t header_written = pwrite(fd, &header, sizeof(header), 0);
+        assert(header_written == sizeof(header));
+        for (size_t max_size : { size_t{ 10000 }, std::numeric_limits<size_t>::max() }) {
+            lseek(fd, 0, SEEK_SET);
+            ResetVectorStats();
+            Vector<Point> corrupt;
+            try {
+                ReadVector(fd, corrupt, max_size);
+                assert(false);
+            }
+            catch (const std::length_error&) {
+                assert(max_size == 10000 && GetVectorStats().allocations == 0);
+            }
+            catch (const std::runtime_error&) {
+                assert(max_size != 10000);
+                assert(GetVectorStats().bytes_allocated <= 2 * vector_detail::SERIALIZED_READ_CHUNK_BYTES);
+            }
+            assert(corrupt.Size() == 0);
+        }
+        close(fd);
+        std::filesystem::remove(path);
+    }
+}
+
+void Test25() {
+    using Alloc = TrackingAllocator<std::string>;
+    {
+        Alloc::ResetCounters();
+        Alloc alloc(1);
+        std::string* buffer = alloc.allocate(8);
+        for (int i = 0; i < 5; ++i) {
+            new (buffer + i) std::string(20, static_cast<char>('a' + i));
+        }
+        auto v = Vector<std::string, Alloc>::Adopt(buffer, 5, 8, alloc);
+        assert(v.begin() == buffer && v.Size() == 5 && v.Capacity() == 8);
+        assert(v.GetAllocator() == alloc && v[4] == std::string(20, 'e'));
+        v.PushBack("f");
+        assert(v.begin() == buffer && Alloc::num_allocations == 1);
+
+        const ReleasedBuffer<std::string> released = v.Release();
+        assert(released.ptr == buffer && released.size == 6 && released.capacity == 8);
+        assert(v.Size() == 0 && v.Capacity() == 0 && v.begin() == nullptr);
+        assert(Alloc::num_deallocations == 0);
+
+        // the released buffer goes back into a vector, which frees it
+        {
+            auto w = Vector<std::string, Alloc>::Adopt(released.ptr, released.size, released.capacity, alloc);
+            assert(w[5] == "f");
+        }
+        assert(Alloc::num_allocations == 1 && Alloc::num_deallocations == 1);
+    }
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, 4> inline_items(3);
+        const ReleasedBuffer<Obj> released = inline_items.Release();
+        assert(released.size == 3 && released.capacity >= 3 && inline_items.Size() == 0);
+        assert(Obj::GetAliveObjectCount() == 3);
+        std::destroy_n(released.ptr, released.size);
+        std::allocator<Obj>{}.deallocate(released.ptr, released.capacity);
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        SmallVector<Obj, 4> empty;
+        assert(empty.Release().ptr == nullptr);
+        const auto adopted_empty = Vector<int>::Adopt(nullptr, 0, 0);
+        assert(adopted_empty.Size() == 0 && adopted_empty.Capacity() == 0);
+    }
+}
+
+constexpr StaticVector<int, 16> MakeSquares() {
+    StaticVector<int, 16> squares;
+    for (int i = 0; i < 10; ++i) {
+        squares.PushBack(i * i);
+    }
+    squares.Erase(squares.begin());
+    squares.Insert(squares.begin(), -1);
+    return squares;
+}
+
+void Test26() {
+    {
+        constexpr StaticVector<int, 16> squares = MakeSquares();
+        static_assert(squares.Size() == 10 && squares[0] == -1 && squares[9] == 81);
+        static_assert(StaticVector<int, 4>{ 1, 2, 3 }.Size() == 3 && StaticVector<int, 4>::Capacity() == 4);
+        static_assert(sizeof(StaticVector<int, 16>) == 16 * sizeof(int) + sizeof(size_t));
+        int sum = 0;
+        for (int square : squares) {
+            sum += square;
+        }
+        assert(sum == 284);
+    }
+    {
+        Obj::ResetCounters();
+        StaticVector<Obj, 8> v(3);
+        assert(Obj::GetAliveObjectCount() == 3);
+        v.EmplaceBack(7);
+        assert(v[3].id == 7);
+        v.Emplace(v.begin() + 1, 42);
+        assert(v.Size() == 5 && v[1].id == 42 && v[4].id == 7);
+        v.Erase(v.begin());
+        assert(v.Size() == 4 && v[0].id == 42 && Obj::GetAliveObjectCount() == 4);
+
+        StaticVector<Obj, 8> copy(v);
+        assert(copy.Size() == 4 && copy[3].id == 7 && Obj::GetAliveObjectCount() == 8);
+        StaticVector<Obj, 8> other(6);
+        other = copy;
+        assert(other.Size() == 4 && other[0].id == 42 && Obj::GetAliveObjectCount() == 12);
+        other = std::move(v);
+        assert(other.Size() == 4 && other[3].id == 7);
+        v.Clear();
+        copy.Resize(1);
+        assert(Obj::GetAliveObjectCount() == 5);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        StaticVector<std::string, 4> strings{ "a", "b" };
+        strings.Insert(strings.begin(), strings[1]);
+        assert(strings[0] == "b" && strings[1] == "a" && strings[2] == "b");
+    }
+}
+
+void Test27() {
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        v.Reserve(8);
+        for (int i = 0; i < 5; ++i) {
+            [[maybe_unused]] Obj& item = v.EmplaceBack(i);
+        }
+        Obj value(42);
+        Obj::ResetCounters();
+        [[maybe_unused]] auto pos = v.Emplace(v.begin() + 1, std::move(value));
+        // the last item is moved to the end and three are shifted, no temporary value is assigned
+        assert(pos == v.begin() + 1 && v.Size() == 6 && v[1].id == 42 && v[5].id == 4);
+        assert(Obj::num_moved == 2 && Obj::num_move_assigned == 3 && Obj::num_destroyed == 1);
+
+        // an argument that refers to an item is copied before the shift
+        pos = v.Emplace(v.begin(), v[3]);
+        assert(pos == v.begin() && v[0].id == 2 && v[4].id == 2 && v.Size() == 7);
+
+        // a constructor that may throw builds in the gap too, the tail is moved back if it does
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            pos = v.Emplace(v.begin() + 2);
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 7 && v[0].id == 2 && v[2].id == 42 && v[6].id == 4);
+    }
+    {
+        RelocatableObj::ResetCounters();
+        Vector<RelocatableObj> v;
+        v.Reserve(8);
+        for (int i = 0; i < 4; ++i) {
+            [[maybe_unused]] RelocatableObj& item = v.EmplaceBack(i);
+        }
+        [[maybe_unused]] auto pos = v.Emplace(v.begin() + 2, 10);
+        assert(pos == v.begin() + 2 && v[2].id == 10 && v[4].id == 3);
+        assert(RelocatableObj::num_moved == 0 && RelocatableObj::num_destroyed == 0);
+        pos = v.Emplace(v.begin(), v[4]);
+        assert(pos == v.begin() && v[0].id == 3 && v[5].id == 3 && RelocatableObj::num_copied == 1);
+    }
+    {
+        Vector<int> sorted{ 10, 20, 60, 70 };
+        sorted.Reserve(16);
+        const auto it = sorted.EmplaceMany(sorted.begin() + 2, 3, [](size_t i) {
+            return static_cast<int>(30 + i * 10);
+        });
+        assert(it == sorted.begin() + 2);
+        const std::vector<int> expected{ 10, 20, 30, 40, 50, 60, 70 };
+        assert(std::equal(sorted.begin(), sorted.end(), expected.begin(), expected.end()));
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        for (int i = 0; i < 4; ++i) {
+            [[maybe_unused]] Obj& item = v.EmplaceBack(i);
+        }
+        v.EmplaceMany(v.begin() + 1, 10, [](size_t i) {
+            return Obj(static_cast<int>(100 + i));
+        });
+        assert(v.Size() == 14 && v[1].id == 100 && v[10].id == 109 && v[11].id == 1 && v[13].id == 3);
+        try {
+            v.EmplaceMany(v.begin(), 3, [](size_t i) {
+                if (i == 2) {
+                    throw std::runtime_error("factory");
+                }
+                return Obj(-1);
+            });
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 14 && v[0].id == 0);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test28() {
+    {
+        const int keys[] = { 0, 1, 5, 6, 100 };
+        for (size_t size = 0; size <= std::size(keys); ++size) {
+            for (int key = -1; key <= 101; ++key) {
+                const size_t expected = std::lower_bound(keys, keys + size, key) - keys;
+                assert(vector_detail::BranchlessLowerBound(keys, size, key, std::less<int>{}) == expected);
+            }
+        }
+    }
+    {
+        FlatSet<int> set{ 5, 1, 3, 3, 9 };
+        assert(set.Size() == 4 && *set.begin() == 1 && set.Contains(9) && !set.Contains(4));
+        assert(set.Insert(4).second && !set.Insert(4).second);
+        const int more[] = { 10, 2, 4, 0, 10 };
+        set.InsertRange(std::begin(more), std::end(more));
+        const std::vector<int> expected{ 0, 1, 2, 3, 4, 5, 9, 10 };
+        assert(std::equal(set.begin(), set.end(), expected.begin(), expected.end()));
+        assert(set.Erase(3) == 1 && set.Erase(3) == 0 && set.Find(3) == set.end());
+
+        FlatSet<int, std::greater<int>> descending{ 1, 3, 2 };
+        assert(*descending.begin() == 3 && *descending.LowerBound(2) == 2);
+    }
+    {
+        FlatMap<std::string, int> map{ { "b", 2 }, { "a", 1 }, { "b", 20 } };
+        assert(map.Size() == 2 && map.At("b") == 2 && map.Keys()[0] == "a");
+        assert(map.Find("c") == nullptr && !map.Contains("c"));
+        map["c"] += 3;
+        assert(map.At("c") == 3 && map.Values()[2] == 3);
+        assert(!map.Insert("a", 100).second && map.At("a") == 1);
+        assert(!map.InsertOrAssign("a", 100).second && map.At("a") == 100);
+        assert(*map.TryEmplace("d", 4).first == 4);
+        try {
+            map.At("e");
+            assert(false);
+        }
+        catch (const std::out_of_range&) {
+        }
+
+        const std::map<std::string, int> batch{ { "0", 0 }, { "a", -1 }, { "bb", 22 }, { "z", 26 } };
+        map.InsertRange(batch.begin(), batch.end());
+        const std::vector<std::string> expected_keys{ "0", "a", "b", "bb", "c", "d", "z" };
+        const std::vector<int> expected_values{ 0, 100, 2, 22, 3, 4, 26 };
+        assert(std::equal(map.Keys().begin(), map.Keys().end(), expected_keys.begin(), expected_keys.end()));
+        assert(std::equal(map.Values().begin(), map.Values().end(), expected_values.begin(), expected_values.end()));
+        assert(map.Erase("bb") == 1 && map.Size() == 6 && map.At("c") == 3);
+    }
+    {
+        // a comparator that throws in the middle of InsertRange leaves sorted unique keys
+        struct ThrowingLess {
+            bool operator()(int lhs, int rhs) const {
+                if (*countdown > 0 && --*countdown == 0) {
+                    throw std::runtime_error("comparison failed");
+                }
+                return lhs < rhs;
+            }
+
+            int* countdown;
+        };
+        const auto is_sorted_and_unique = [](const auto& keys) {
+            return std::adjacent_find(keys.begin(), keys.end(), std::greater_equal<int>{}) == keys.end();
+        };
+        const int more[] = { 7, 2, 8, 2, 5, 0, 9, 4 };
+        for (int throw_at = 1; throw_at < 100; ++throw_at) {
+            int countdown = 0;
+            FlatSet<int, ThrowingLess> set({ 1, 3, 5, 6 }, ThrowingLess{ &countdown });
+            FlatMap<int, int, ThrowingLess> map({ { 1, 1 }, { 3, 3 }, { 5, 5 }, { 6, 6 } }, ThrowingLess{ &countdown });
+            countdown = throw_at;
+            try {
+                set.InsertRange(std::begin(more), std::end(more));
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(is_sorted_and_unique(set.Keys()));
+            countdown = throw_at;
+            try {
+                const std::vector<std::pair<int, int>> batch{ { 7, 7 }, { 2, 2 }, { 8, 8 }, { 2, 2 }, { 0, 0 } };
+                map.InsertRange(batch.begin(), batch.end());
+            }
+            catch (const std::runtime_error&) {
+            }
+            assert(is_sorted_and_unique(map.Keys()) && map.Values().Size() == map.Size());
+            for (size_t i = 0; i < map.Size(); ++i) {
+                assert(map.Values()[i] == map.Keys()[i]);
+            }
+        }
+    }
+    {
+        // the same contents as std::map after random operations
+        std::map<int, int> reference;
+        FlatMap<int, int> map;
+        unsigned state = 1;
+        for (int i = 0; i < 2000; ++i) {
+            state = state * 1103515245 + 12345;
+            const int key = static_cast<int>(state >> 16) % 300;
+            switch (i % 3) {
+            case 0:
+                reference.insert({ key, i });
+                map.Insert(key, i);
+                break;
+            case 1:
+                reference.erase(key);
+                map.Erase(key);
+                break;
+            default:
+                assert(map.Contains(key) == (reference.count(key) != 0));
+            }
+        }
+        assert(map.Size() == reference.size());
+        size_t index = 0;
+        for (const auto& [key, value] : reference) {
+            assert(map.Keys()[index] == key && map.Values()[index] == value);
+            ++index;
+        }
+    }
+}
+
+void Test29() {
+    {
+        SoaVector<int, double, std::string> rows;
+        for (int i = 0; i < 100; ++i) {
+            const auto [id, weight, name] = rows.EmplaceBack(i, i * 0.5, std::to_string(i));
+            assert(id == i && weight == i * 0.5 && name == std::to_string(i));
+        }
+        assert(rows.Size() == 100 && rows.Capacity() >= 100);
+
+        // a column is contiguous
+        const ColumnSpan<double> weights = rows.Column<1>();
+        assert(weights.Size() == 100 && &weights[99] - &weights[0] == 99);
+        assert(std::accumulate(weights.begin(), weights.end(), 0.0) == 2475.0);
+        for (int& id : rows.Column<0>()) {
+            id *= 2;
+        }
+
+        int count = 0;
+        for (auto [id, weight, name] : rows) {
+            assert(id == count * 2 && name == std::to_string(count));
+            weight = 0;
+            ++count;
+        }
+        assert(count == 100 && rows.Column<1>()[50] == 0);
+        assert(std::get<2>(rows[7]) == "7");
+
+        // a row may be appended from a row of the same vector
+        rows.Reserve(rows.Size());
+        const auto [id, weight, name] = rows[3];
+        rows.EmplaceBack(id, weight, name);
+        assert(std::get<2>(rows[100]) == "3");
+
+        auto copy = rows;
+        rows.PopBack();
+        assert(copy.Size() == 101 && rows.Size() == 100 && std::get<0>(copy[100]) == 6);
+        rows.Clear();
+        assert(rows.Size() == 0 && rows.begin() == rows.end());
+    }
+    {
+        // a throwing copy of one column leaves all columns as they were
+        Obj::ResetCounters();
+        struct ThrowingMove {
+            ThrowingMove() = default;
+            ThrowingMove(const ThrowingMove& other)
+                : obj(other.obj) {
+            }
+            Obj obj;
+        };
+        SoaVector<Obj, ThrowingMove> rows;
+        rows.Reserve(4);
+        for (int i = 0; i < 4; ++i) {
+            rows.EmplaceBack(i, ThrowingMove());
+        }
+        std::get<1>(rows[2]).obj.throw_on_copy = true;
+        try {
+            rows.EmplaceBack(10, ThrowingMove());
+            assert(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+        assert(rows.Size() == 4 && rows.Capacity() == 4 && std::get<0>(rows[3]).id == 3);
+        assert(Obj::GetAliveObjectCount() == 8);
+
+        std::get<1>(rows[2]).obj.throw_on_copy = false;
+        rows.EmplaceBack(10, ThrowingMove());
+        assert(rows.Size() == 5 && std::get<0>(rows[4]).id == 10);
+        assert(Obj::GetAliveObjectCount() == 10);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test30() {
+    {
+        Obj::ResetCounters();
+        RingVector<Obj> queue;
+        for (int i = 0; i < 6; ++i) {
+            queue.EmplaceBack(i);
+        }
+        // the head moves around the buffer without shifting the items
+        for (int i = 6; i < 100; ++i) {
+            assert(queue[0].id == i - 6);
+            queue.PopFront();
+            queue.EmplaceBack(i);
+        }
+        assert(queue.Size() == 6 && queue.Capacity() == 8 && queue[5].id == 99);
+        assert(Obj::num_moved <= 6 + 4);
+
+        queue.EmplaceFront(-1);
+        queue.EmplaceFront(-2);
+        // a full buffer is linearized on growth, the new item refers to an old one
+        queue.PushFront(queue[7]);
+        assert(queue.Size() == 9 && queue.Capacity() == 16);
+        assert(queue[0].id == 99 && queue[1].id == -2 && queue[2].id == -1 && queue[3].id == 94);
+
+        int expected = 94;
+        for (auto it = queue.begin() + 3; it != queue.end(); ++it) {
+            assert(it->id == expected++);
+        }
+        queue.PopBack();
+        RingVector<Obj> copy(queue);
+        assert(copy.Size() == 8 && copy[7].id == 98);
+        queue.Clear();
+        assert(queue.Size() == 0 && Obj::GetAliveObjectCount() == 8);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // a window of the latest four samples
+        RingVector<int> window(4, OVERWRITE_OLDEST);
+        for (int i = 0; i < 10; ++i) {
+            window.PushBack(i);
+        }
+        assert(window.Size() == 4 && window.Capacity() == 4);
+        assert(window[0] == 6 && window[3] == 9);
+        window.PushFront(5);
+        assert(window[0] == 5 && window[3] == 8);
+        window.PopFront();
+        window.PushBack(9);
+        assert(window[0] == 6 && window[3] == 9 && window.Size() == 4);
+
+        // a moved-from window has no buffer and grows again instead of overwriting
+        RingVector<int> moved(std::move(window));
+        assert(moved.IsOverwritingOldest() && moved[3] == 9);
+        assert(window.Capacity() == 0 && !window.IsOverwritingOldest());
+        window.PushBack(1);
+        window.PushFront(0);
+        assert(window.Size() == 2 && window[0] == 0 && window[1] == 1);
+        window = std::move(moved);
+        assert(window.IsOverwritingOldest() && window.Size() == 4 && !moved.IsOverwritingOldest());
+        moved.PushBack(2);
+        assert(moved.Size() == 1 && moved[0] == 2);
+    }
+    {
+        // rings on different resources copy and move the items instead of swapping buffers
+        std::pmr::monotonic_buffer_resource first_resource;
+        std::pmr::monotonic_buffer_resource second_resource;
+        using PmrRing = RingVector<std::pmr::string, std::pmr::polymorphic_allocator<std::pmr::string>>;
+        PmrRing first(3, OVERWRITE_OLDEST, &first_resource);
+        for (const char* text : { "a", "b", "c", "d" }) {
+            first.PushBack(std::pmr::string(text, &first_resource));
+        }
+        PmrRing second(&second_resource);
+        second.PushBack(std::pmr::string("x", &second_resource));
+        second = first;
+        assert(second.GetAllocator().resource() == &second_resource && second.IsOverwritingOldest());
+        assert(second.Size() == 3 && second[0] == "b" && second[2] == "d");
+
+        PmrRing third(&second_resource);
+        third = std::move(first);
+        assert(third.GetAllocator().resource() == &second_resource && third.IsOverwritingOldest());
+        assert(third.Size() == 3 && third[1] == "c" && first.Size() == 0);
+    }
+    {
+        // growth of a wrapped buffer keeps the order of the items
+        std::string long_string(100, 'x');
+        RingVector<std::string> strings;
+        strings.Reserve(2);
+        strings.PushBack("a");
+        strings.PushFront("b");
+        strings.PushBack(long_string);
+        assert(strings[0] == "b" && strings[1] == "a" && strings[2] == long_string);
+    }
+}
+
+void Test31() {
+    using CachedVector = Vector<int, CachingAllocator<int>>;
+    TrimThreadCache();
+    ResetThreadCacheStats();
+    {
+        CachedVector v(10);
+        // the capacity fills the 64 byte block
+        assert(v.Capacity() == 16);
+    }
+    assert(GetThreadCacheStats().misses == 1 && GetThreadCacheStats().cached_bytes == 64);
+    for (int i = 0; i < 100; ++i) {
+        CachedVector v(static_cast<size_t>(i % 16 + 1));
+        v.PushBack(i);
+    }
+    // PushBack of a full vector of 16 items needed blocks of 128 bytes as well
+    ThreadCacheStats stats = GetThreadCacheStats();
+    assert(stats.misses == 2 && stats.hits == 100 + 6 - 1 && stats.cached_bytes == 64 + 128);
+
+    // big buffers bypass the cache
+    {
+        CachedVector big(vector_detail::MAX_CACHED_BLOCK);
+        assert(big.Capacity() == vector_detail::MAX_CACHED_BLOCK);
+    }
+    assert(GetThreadCacheStats().cached_bytes == 64 + 128);
+
+    // the budget limits the cached bytes
+    SetThreadCacheBudget(64 * 3);
+    {
+        Vector<CachedVector> many;
+        for (int i = 0; i < 10; ++i) {
+            [[maybe_unused]] CachedVector& item = many.EmplaceBack(10);
+        }
+    }
+    assert(GetThreadCacheStats().cached_bytes <= 64 * 3);
+    SetThreadCacheBudget(size_t{ 4 } << 20);
+
+    // buffers freed by another thread go to its cache, which it gives back when it exits
+    CachedVector shared(1000);
+    std::thread([&shared] {
+        CachedVector(std::move(shared)).PushBack(1);
+        assert(GetThreadCacheStats().cached_bytes != 0);
+    }).join();
+
+    TrimThreadCache();
+    assert(GetThreadCacheStats().cached_bytes == 0);
+}
+
+// runs f in a child process, true if the child was stopped by a failed check
+template <typename Function>
+bool FailsInChild(Function f) {
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        // the message of the failed check is expected
+        if (std::freopen("/dev/null", "w", stderr) == nullptr) {
+            _exit(1);
+        }
+        f();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+void Test32() {
+    Vector<int> v{ 1, 2, 3 };
+    assert(v.Data() == &v[0] && std::as_const(v).Data() == &v[0]);
+    if constexpr (!VECTOR_HARDENED_ENABLED) {
+        assert((std::is_same_v<Vector<int>::iterator, int*>));
+    }
+    else {
+        // iterators work as usual while the vector keeps its buffer
+        v.Reserve(10);
+        auto it = v.begin() + 1;
+        v.PushBack(4);
+        assert(*it == 2 && it[2] == 4 && v.end() - it == 3);
+        Vector<int>::const_iterator const_it = it;
+        assert(*const_it == 2 && std::count(v.cbegin(), v.cend(), 4) == 1);
+        it = v.Insert(v.cbegin(), 0);
+        assert(*it == 0 && it[4] == 4);
+
+        assert(FailsInChild([&v] {
+            [[maybe_unused]] int item = v[v.Size()];
+        }));
+        assert(FailsInChild([] {
+            Vector<int> empty;
+            empty.PopBack();
+        }));
+        assert(FailsInChild([&v] {
+            [[maybe_unused]] auto next = v.Erase(v.cend());
+        }));
+        // an iterator taken before a reallocation
+        assert(FailsInChild([&v] {
+            auto first = v.begin();
+            v.ShrinkToFit();
+            v.PushBack(5);
+            [[maybe_unused]] int item = *first;
+        }));
+        // iterators belong to the vector object
+        assert(FailsInChild([&v] {
+            auto first = v.begin();
+            Vector<int> other(std::move(v));
+            [[maybe_unused]] int item = *first;
+        }));
+        assert(FailsInChild([] {
+            Vector<int>::iterator singular;
+            [[maybe_unused]] int item = *singular;
+        }));
+        assert(!FailsInChild([&v] {
+            v.PushBack(6);
+            [[maybe_unused]] int item = *(v.end() - 1);
+        }));
+#ifdef VECTOR_ASAN_ENABLED
+        // the unused capacity is poisoned for raw pointers as well
+        assert(FailsInChild([&v] {
+            volatile int* data = v.Data();
+            [[maybe_unused]] int item = data[v.Size()];
+        }));
+#endif
+    }
+}
+
+void Test33() {
+    Obj::ResetCounters();
+    {
+        Vector<Obj> items(3);
+        for (int i = 0; i < 3; ++i) {
+            items[i].id = i;
+        }
+        CowVector<Obj> original(std::move(items));
+        assert(original.Size() == 3 && !original.IsShared());
+
+        // copies share the items
+        CowVector<Obj> snapshot = original;
+        CowVector<Obj> other_snapshot = snapshot;
+        assert(Obj::num_copied == 0 && original.UseCount() == 3);
+        assert(&std::as_const(snapshot)[1] == &std::as_const(original)[1] && std::as_const(other_snapshot)[2].id == 2);
+
+        // the first change copies the items once into a buffer with room for the new one
+        ResetVectorStats();
+        const int num_moved = Obj::num_moved;
+        snapshot.PushBack(std::as_const(snapshot)[0]);
+        assert(Obj::num_copied == 3 + 1 && Obj::num_moved == num_moved);
+        assert(GetVectorStats().allocations == 1 && GetVectorStats().items_moved == 0);
+        assert(snapshot.Size() == 4 && snapshot[3].id == 0 && !snapshot.IsShared());
+        assert(original.Size() == 3 && original.UseCount() == 2);
+        snapshot.PushBack(Obj(7));
+        assert(Obj::num_copied == 3 + 1);
+
+        // a change of the last owner doesn't copy
+        other_snapshot = CowVector<Obj>();
+        assert(!original.IsShared());
+        auto next = original.Erase(original.cbegin());
+        assert(next->id == 1 && original.Size() == 2 && Obj::num_copied == 3 + 1);
+
+        CowVector<Obj> reader = original;
+        const auto it = reader.Emplace(reader.cbegin() + 1, 5);
+        assert(it->id == 5 && reader.Size() == 3 && original.Size() == 2 && original[1].id == 2);
+        reader.Clear();
+        assert(reader.Size() == 0 && !original.IsShared());
+
+        CowVector<Obj> empty;
+        assert(empty.Size() == 0 && empty.begin() == empty.end() && empty.UseCount() == 0);
+        empty.EmplaceBack(1);
+        assert(empty.Size() == 1 && empty[0].id == 1);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+
+    // readers in other threads drop their copies concurrently
+    CowVector<int> config{ 1, 2, 3 };
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([snapshot = config]() mutable {
+            for (int j = 0; j < 100; ++j) {
+                CowVector<int> copy = snapshot;
+                assert(std::accumulate(copy.begin(), copy.end(), 0) == 6);
+            }
+            snapshot.PushBack(4);
+            assert(snapshot.Size() == 4);
+        });
+    }
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    assert(config.UseCount() == 1 && config.Size() == 3);
+}
+
+void Test34() {
+    // assigning a growing vector reallocates by the growth policy
+    {
+        Vector<int> source;
+        Vector<int> copy;
+        size_t reallocations = 0;
+        for (int i = 0; i < 100; ++i) {
+            source.PushBack(i);
+            const size_t old_capacity = copy.Capacity();
+            copy = source;
+            reallocations += copy.Capacity() != old_capacity;
+            assert(copy.Size() == source.Size() && copy[copy.Size() - 1] == i);
+        }
+        assert(reallocations == 8 && copy.Capacity() == 128);
+    }
+    Obj::ResetCounters();
+    {
+        // an empty vector takes the buffer
+        Vector<Obj> partial(3);
+        const Obj* buffer = &partial[0];
+        Vector<Obj> merged;
+        merged.AppendMove(std::move(partial));
+        assert(&merged[0] == buffer && merged.Size() == 3 && partial.Size() == 0 && partial.Capacity() == 0);
+
+        // the others are relocated to a growing buffer
+        for (int i = 0; i < 4; ++i) {
+            Vector<Obj> next(5);
+            next[0].id = i;
+            merged.AppendMove(std::move(next));
+            assert(next.Size() == 0 && merged[3 + i * 5].id == i);
+        }
+        assert(merged.Size() == 23 && merged.Capacity() == 32);
+        assert(Obj::num_copied == 0 && Obj::GetAliveObjectCount() == 23);
+
+        // a reserved buffer is kept
+        Vector<Obj> reserved;
+        reserved.Reserve(100);
+        reserved.AppendMove(std::move(merged));
+        assert(reserved.Capacity() == 100 && reserved.Size() == 23 && merged.Size() == 0);
+
+        Vector<Obj> middle;
+        middle.PushBack(Obj(-1));
+        middle.PushBack(Obj(-2));
+        auto it = reserved.Splice(reserved.cbegin() + 1, std::move(middle));
+        assert(it->id == -1 && (it + 1)->id == -2 && reserved.Size() == 25 && middle.Size() == 0);
+        assert(reserved[10].id == 1 && reserved[15].id == 2 && reserved[20].id == 3);
+        assert(Obj::num_copied == 0 && Obj::GetAliveObjectCount() == 25);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+
+    // items that throw on move stay in other whichever copy fails, with or without spare capacity
+    for (size_t capacity : { size_t{ 4 }, size_t{ 100 } }) {
+        for (int countdown = 1;; ++countdown) {
+            bool is_thrown = false;
+            {
+                Vector<CopyOnlyObj> target(4);
+                target.Reserve(capacity);
+                Vector<CopyOnlyObj> other;
+                for (int i = 1; i <= 3; ++i) {
+                    other.PushBack(CopyOnlyObj{ i });
+                }
+                CopyOnlyObj::copy_throw_countdown = countdown;
+                try {
+                    [[maybe_unused]] auto it = target.Splice(target.cbegin() + 1, std::move(other));
+                }
+                catch (const std::runtime_error&) {
+                    is_thrown = true;
+                }
+                CopyOnlyObj::copy_throw_countdown = 0;
+                if (is_thrown) {
+                    assert(target.Size() == 4 && other.Size() == 3);
+                    assert(other[0].id == 1 && other[1].id == 2 && other[2].id == 3);
+                }
+                else {
+                    assert(target.Size() == 7 && other.Size() == 0 && target[1].id == 1 && target[3].id == 3);
+                }
+                assert(CopyOnlyObj::num_alive == static_cast<int>(target.Size() + other.Size()));
+            }
+            assert(CopyOnlyObj::num_alive == 0);
+            if (!is_thrown) {
+                break;
+            }
+        }
+    }
+
+    // inline items are relocated and other allocators don't give their buffers away
+    SmallVector<std::string, 2> small{ "a" };
+    SmallVector<std::string, 2> target;
+    target.AppendMove(std::move(small));
+    assert(target.Size() == 1 && target[0] == "a" && small.Size() == 0);
+    std::pmr::monotonic_buffer_resource resource;
+    Vector<int, std::pmr::polymorphic_allocator<int>> pmr_items({ 1, 2 }, &resource);
+    Vector<int, std::pmr::polymorphic_allocator<int>> heap_items{ 3 };
+    heap_items.AppendMove(std::move(pmr_items));
+    assert(heap_items.Size() == 3 && heap_items[1] == 1 && heap_items.GetAllocator().resource() != &resource);
+}
+
+void Test35() {
+    ResetVectorTrace();
+    Vector<int> v;
+    const unsigned push_line = __LINE__ + 2;
+    for (int i = 0; i < 100; ++i) {
+        v.PushBack(i);
+    }
+    v.Reserve(1000);
+    const unsigned reserve_line = __LINE__ - 1;
+    v.Reserve(10);
+    [[maybe_unused]] int& item = Vector<int>(1).EmplaceBack(1);
+
+    const VectorTraceEvents trace = GetVectorTrace();
+    // growths to 1, 2, ..., 128, the Reserve and the growth of EmplaceBack without a call site
+    assert(trace.size == 10 && trace.dropped == 0);
+    for (size_t i = 0; i < 8; ++i) {
+        const VectorGrowthEvent& event = trace.events[i];
+        assert(event.site.line == push_line && std::string(event.site.file).find("main.cpp") != std::string::npos);
+        assert(std::string(event.site.function) == "Test35");
+        assert(event.old_capacity == (i == 0 ? 0 : size_t{ 1 } << (i - 1)) && event.new_capacity == size_t{ 1 } << i);
+        assert(event.items_relocated == event.old_capacity && event.item_size == sizeof(int));
+    }
+    assert(trace.events[8].site.line == reserve_line && trace.events[8].new_capacity == 1000);
+    assert(trace.events[8].items_relocated == 100 && trace.events[8].start_ns >= trace.events[7].start_ns);
+    assert(trace.events[9].site.file == nullptr && trace.events[9].new_capacity == 2);
+
+    // a growth that fails is not recorded
+    Obj::ResetCounters();
+    Vector<Obj> objects;
+    Obj::default_construction_throw_countdown = 1;
+    try {
+        [[maybe_unused]] Obj& item = objects.EmplaceBack();
+        assert(false);
+    }
+    catch (const std::runtime_error&) {
+    }
+    assert(GetVectorTrace().size == 10);
+
+    std::ostringstream out;
+    WriteChromeTrace(out, GetVectorTrace(), 7);
+    const std::string json = out.str();
+    assert(json.rfind("{\"traceEvents\":[", 0) == 0);
+    assert(json.find("main.cpp:" + std::to_string(push_line) + "\",\"cat\":\"vector\",\"ph\":\"X\",\"pid\":1,\"tid\":7")
+           != std::string::npos);
+    assert(json.find("\"name\":\"unknown site\"") != std::string::npos);
+    assert(json.find("\"old_capacity\":128,\"new_capacity\":1000,\"items_relocated\":100,\"bytes\":4000")
+           != std::string::npos);
+    assert(json.find("\"dropped_events\":0}}") != std::string::npos);
+    ResetVectorTrace();
+    assert(GetVectorTrace().size == 0);
+
+    // every method that may grow records the line that called it
+    const auto last_growth_is_at = [](unsigned line) {
+        const VectorTraceEvents events = GetVectorTrace();
+        const VectorGrowthEvent& event = events.events[events.size - 1];
+        return event.site.line == line && std::string(event.site.file).find("main.cpp") != std::string::npos;
+    };
+    const std::vector<int> ints(100, 1);
+    Vector<int> w(ints.begin(), ints.end());
+    assert(last_growth_is_at(__LINE__ - 1));
+    w.ResizeDefaultInit(1000);
+    assert(last_growth_is_at(__LINE__ - 1));
+    w.ResizeAndOverwrite(2000, [](int*, size_t count) { return count; });
+    assert(last_growth_is_at(__LINE__ - 1));
+    w.Assign(4000, 1);
+    assert(last_growth_is_at(__LINE__ - 1));
+    [[maybe_unused]] auto inserted = w.Insert(w.cbegin(), 10000, 1);
+    assert(last_growth_is_at(__LINE__ - 1));
+    [[maybe_unused]] auto emplaced = w.EmplaceMany(w.cbegin(), 20000, [](size_t i) { return static_cast<int>(i); });
+    assert(last_growth_is_at(__LINE__ - 1));
+    w.PopBack();
+    w.ShrinkToFit();
+    assert(last_growth_is_at(__LINE__ - 1));
+    [[maybe_unused]] int& last = w.EmplaceBackAt(VectorCallSite::Current(), 1);
+    assert(last_growth_is_at(__LINE__ - 1));
+    Vector<int> full(1);
+    [[maybe_unused]] auto first = full.EmplaceAt(VectorCallSite::Current(), full.cbegin(), 1);
+    assert(last_growth_is_at(__LINE__ - 1));
+    w.AppendMove(Vector<int>(ints.begin(), ints.end()));
+    assert(last_growth_is_at(__LINE__ - 1));
+    [[maybe_unused]] auto spliced = w.Splice(w.cbegin(), Vector<int>(w.Capacity()));
+    assert(last_growth_is_at(__LINE__ - 1));
+    Vector<int> u;
+    u.Assign(ints.begin(), ints.end());
+    assert(last_growth_is_at(__LINE__ - 1));
+    ResetVectorTrace();
 }
 
 int main() {
@@ -648,7 +2833,35 @@ int main() {
         Test4();
         Test5();
         Test6();
-        Benchmark();
+        Test7();
+        Test8();
+        Test9();
+        Test10();
+        Test11();
+        Test12();
+        Test13();
+        Test14();
+        Test15();
+        Test16();
+        Test17();
+        Test18();
+        Test19();
+        Test20();
+        Test21();
+        Test22();
+        Test23();
+        Test24();
+        Test25();
+        Test26();
+        Test27();
+        Test28();
+        Test29();
+        Test30();
+        Test31();
+        Test32();
+        Test33();
+        Test34();
+        Test35();
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -0,0 +1,74 @@
+// Tests of the containers built without VECTOR_ENABLE_STATS, VECTOR_ENABLE_TRACE and VECTOR_HARDENED,
+// so the discarded branches of the opt-in features are compiled too: nothing may be counted or traced.
+// Build: g++ -std=c++17 main_no_features.cpp -o tests_no_features
+
+#include "vector.h"
+#include "small_vector.h"
+#include "ring_vector.h"
+#include "soa_vector.h"
+#include "incremental_vector.h"
+#include "obj.h"
+
+#include <cassert>
+#include <exception>
+#include <iostream>
+#include <string>
+
+static_assert(!VECTOR_STATS_ENABLED && !VECTOR_TRACE_ENABLED && !VECTOR_HARDENED_ENABLED);
+
+void TestVector() {
+    const size_t SIZE = 100;
+    Vector<Obj> v;
+    for (size_t i = 0; i < SIZE; ++i) {
+        v.PushBack(Obj{ static_cast<int>(i) });
+    }
+    v.Reserve(SIZE * 4);
+    v.Resize(SIZE * 2);
+    [[maybe_unused]] Vector<Obj>::iterator inserted = v.Insert(v.begin(), Obj{ -1 });
+    v.Append({ Obj{ 1 }, Obj{ 2 } });
+    v.ShrinkToFit();
+    assert(v.Size() == SIZE * 2 + 3);
+    assert(v[0].id == -1);
+    assert(v[SIZE].id == static_cast<int>(SIZE - 1));
+
+    Vector<int> ints(SIZE);
+    ints.Reserve(SIZE * 2);
+    assert(ints.Size() == SIZE);
+}
+
+void TestOtherVectors() {
+    const size_t SIZE = 50;
+    SmallVector<std::string, 4> small;
+    RingVector<int> ring;
+    SoaVector<int, std::string> rows;
+    IncrementalVector<int> incremental;
+    for (size_t i = 0; i < SIZE; ++i) {
+        small.PushBack(std::to_string(i));
+        ring.PushFront(static_cast<int>(i));
+        [[maybe_unused]] auto row = rows.EmplaceBack(static_cast<int>(i), std::to_string(i));
+        incremental.PushBack(static_cast<int>(i));
+    }
+    assert(small.Size() == SIZE && small[SIZE - 1] == std::to_string(SIZE - 1));
+    assert(ring.Size() == SIZE && ring[0] == static_cast<int>(SIZE - 1));
+    assert(rows.Size() == SIZE);
+    assert(incremental.Size() == SIZE);
+}
+
+void TestNothingCollected() {
+    const VectorStats stats = GetVectorStats();
+    assert(stats.allocations == 0);
+    assert(stats.reallocations == 0);
+    assert(stats.items_moved == 0 && stats.items_copied == 0 && stats.items_relocated == 0);
+    assert(GetVectorTrace().size == 0);
+}
+
+int main() {
+    try {
+        TestVector();
+        TestOtherVectors();
+        TestNothingCollected();
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include "vector.h"
+
+#include <cerrno>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Buffers mapped directly from the kernel. Vector grows such buffers with mremap on Linux,
+// which moves page table entries instead of copying bytes; other systems map a new region
+// and copy the bytes.
+
+namespace vector_detail {
+
+    inline constexpr size_t HUGE_PAGE_SIZE = size_t{ 2 } << 20;
+
+    inline size_t PageSize() noexcept {
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return page_size;
+    }
+
+    inline size_t RoundUpTo(size_t bytes, size_t granularity) noexcept {
+        return (bytes + granularity - 1) / granularity * granularity;
+    }
+
+    [[noreturn]] inline void ThrowSystemError(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    // maps bytes of shared memory of fd at offset 0, or anonymous memory if fd is -1;
+    // hugetlb memory is tried first if it's asked for and ordinary pages are taken if there is none
+    inline void* MapMemory(size_t bytes, int fd = -1, bool use_hugetlb = false) {
+        const int prot = PROT_READ | PROT_WRITE;
+        void* ptr = MAP_FAILED;
+        if (fd == -1) {
+#if defined(MAP_HUGETLB)
+            if (use_hugetlb) {
+                ptr = mmap(nullptr, bytes, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            }
+#endif
+            if (ptr == MAP_FAILED) {
+                ptr = mmap(nullptr, bytes, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            }
+#if defined(MADV_HUGEPAGE)
+            // transparent huge pages cut the TLB misses of big buffers
+            if (ptr != MAP_FAILED && bytes >= HUGE_PAGE_SIZE) {
+                madvise(ptr, bytes, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        else {
+            ptr = mmap(nullptr, bytes, prot, MAP_SHARED, fd, 0);
+        }
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    // resizes a mapping keeping its bytes, the old mapping stays valid if an exception is thrown;
+    // a file mapping has to be resized together with the file
+    inline void* RemapMemory(void* ptr, size_t old_bytes, size_t new_bytes, int fd = -1) {
+#if defined(__linux__)
+        void* new_ptr = mremap(ptr, old_bytes, new_bytes, MREMAP_MAYMOVE);
+        if (new_ptr != MAP_FAILED) {
+#if defined(MADV_HUGEPAGE)
+            if (fd == -1 && new_bytes >= HUGE_PAGE_SIZE) {
+                madvise(new_ptr, new_bytes, MADV_HUGEPAGE);
+            }
+#endif
+            return new_ptr;
+        }
+        // hugetlb mappings can't always be remapped
+#endif
+        void* new_ptr_copy = MapMemory(new_bytes, fd);
+        if (fd == -1) {
+            std::memcpy(new_ptr_copy, ptr, std::min(old_bytes, new_bytes));
+        }
+        munmap(ptr, old_bytes);
+        return new_ptr_copy;
+    }
+
+}  // namespace vector_detail
+
+// allocator that maps whole pages for every buffer, worth it for big buffers of trivially
+// relocatable items: Vector grows them with reallocate in place of copying. The capacity fills
+// the last page; with USE_HUGETLB buffers are taken from the reserved huge pages when there are
+// some, so the sizes are rounded to 2 MB. Buffers of 2 MB and more are advised to use
+// transparent huge pages
+template <typename T, bool USE_HUGETLB = false>
+struct MmapAllocator {
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = MmapAllocator<U, USE_HUGETLB>;
+    };
+
+    MmapAllocator() = default;
+
+    template <typename U>
+    MmapAllocator(const MmapAllocator<U, USE_HUGETLB>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        return allocate_at_least(n).ptr;
+    }
+
+    AllocationResult<T> allocate_at_least(size_t n) {
+        const size_t bytes = MappingBytes(n);
+        return { static_cast<T*>(vector_detail::MapMemory(bytes, -1, USE_HUGETLB)), bytes / sizeof(T) };
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        munmap(static_cast<void*>(ptr), MappingBytes(n));
+    }
+
+    T* reallocate(T* ptr, size_t old_n, size_t new_n) {
+        return static_cast<T*>(vector_detail::RemapMemory(static_cast<void*>(ptr), MappingBytes(old_n),
+                                                          MappingBytes(new_n)));
+    }
+
+    template <typename U>
+    bool operator==(const MmapAllocator<U, USE_HUGETLB>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const MmapAllocator<U, USE_HUGETLB>&) const noexcept {
+        return false;
+    }
+
+private:
+    static size_t MappingBytes(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T) - vector_detail::HUGE_PAGE_SIZE) {
+            throw std::bad_array_new_length();
+        }
+        return vector_detail::RoundUpTo(n * sizeof(T), USE_HUGETLB ? vector_detail::HUGE_PAGE_SIZE
+                                                                   : vector_detail::PageSize());
+    }
+};
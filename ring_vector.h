@@ -0,0 +1,338 @@
+#pragma once
+#include "index_iterator.h"
+#include "vector.h"
+
+// selects the mode of RingVector in which a full vector drops the item at the other end
+struct OverwriteOldestTag {
+};
+
+inline constexpr OverwriteOldestTag OVERWRITE_OLDEST{};
+
+// vector in a circular buffer: items are added and removed at both ends in O(1) without shifting,
+// the item i lives at (head_ + i) % Capacity(). Growth moves the items to the start of a new buffer.
+// In the overwrite-oldest mode the capacity is fixed and adding to a full vector replaces the item
+// at the other end, e.g. PushBack drops the front item, which keeps a window of the latest items
+template <typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth>
+class RingVector {
+    using HeapMemory = RawMemory<T, Allocator>;
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+public:
+    using allocator_type = Allocator;
+    using value_type = T;
+    using iterator = vector_detail::IndexIterator<RingVector, false>;
+    using const_iterator = vector_detail::IndexIterator<RingVector, true>;
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator(this, size_);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    RingVector() = default;
+
+    explicit RingVector(const Allocator& alloc) noexcept
+        : data_(alloc) {
+    }
+
+    // a window of the latest capacity items
+    RingVector(size_t capacity, OverwriteOldestTag, const Allocator& alloc = Allocator())
+        : data_(capacity, alloc)
+        , overwrite_oldest_(true) {
+        assert(capacity != 0);
+    }
+
+    RingVector(const RingVector& other)
+        : RingVector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {
+    }
+
+    RingVector(const RingVector& other, const Allocator& alloc)
+        : RingVector(alloc) {
+        Reserve(other.Capacity());
+        for (const T& item : other) {
+            PushBack(item);
+        }
+        overwrite_oldest_ = other.overwrite_oldest_;
+    }
+
+    // the moved-from vector is empty without a buffer and grows like a vector that doesn't overwrite
+    RingVector(RingVector&& other) noexcept
+        : data_(std::move(other.data_))
+        , head_(std::exchange(other.head_, 0))
+        , size_(std::exchange(other.size_, 0))
+        , overwrite_oldest_(std::exchange(other.overwrite_oldest_, false)) {
+    }
+
+    // the items are moved one by one if the buffer of other can't be freed by alloc
+    RingVector(RingVector&& other, const Allocator& alloc)
+        : RingVector(alloc) {
+        if (data_.HasEqualAllocator(other.data_)) {
+            TakeItems(other);
+        }
+        else {
+            Reserve(other.Capacity());
+            for (T& item : other) {
+                PushBack(std::move(item));
+            }
+            overwrite_oldest_ = std::exchange(other.overwrite_oldest_, false);
+            other.Clear();
+        }
+    }
+
+    // the copy is made with the allocator that *this has after the assignment, so its buffer
+    // can be taken over even if the allocators don't propagate
+    RingVector& operator=(const RingVector& rhs) {
+        if (this != &rhs) {
+            constexpr bool PROPAGATE = AllocTraits::propagate_on_container_copy_assignment::value;
+            RingVector rhs_copy(rhs, PROPAGATE ? rhs.GetAllocator() : GetAllocator());
+            Clear();
+            if constexpr (PROPAGATE) {
+                data_.ResetAllocator(rhs_copy.GetAllocator());
+            }
+            TakeItems(rhs_copy);
+        }
+        return *this;
+    }
+
+    RingVector& operator=(RingVector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                                     || AllocTraits::is_always_equal::value) {
+        if (this != &rhs) {
+            if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                Clear();
+                TakeItems(rhs);
+            }
+            else if (data_.HasEqualAllocator(rhs.data_)) {
+                Clear();
+                TakeItems(rhs);
+            }
+            else { // buffer of rhs can't be freed by the allocator of *this, move elements one by one
+                RingVector rhs_moved(std::move(rhs), GetAllocator());
+                Clear();
+                TakeItems(rhs_moved);
+            }
+        }
+        return *this;
+    }
+
+    ~RingVector() {
+        Clear();
+    }
+
+    void Swap(RingVector& other) noexcept {
+        data_.Swap(other.data_);
+        std::swap(head_, other.head_);
+        std::swap(size_, other.size_);
+        std::swap(overwrite_oldest_, other.overwrite_oldest_);
+    }
+
+    Allocator GetAllocator() const noexcept {
+        return data_.GetAllocator();
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return data_.Capacity();
+    }
+
+    bool IsOverwritingOldest() const noexcept {
+        return overwrite_oldest_;
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return data_[Wrap(head_ + index)];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<RingVector&>(*this)[index];
+    }
+
+    // the items are moved to the start of the new buffer; the vector stays untouched if an exception is thrown
+    void Reserve(size_t capacity) {
+        if (capacity > Capacity()) {
+            HeapMemory new_data(capacity, GetAllocator());
+            RelocateTo(new_data, 0);
+            data_.Swap(new_data);
+            head_ = 0;
+        }
+    }
+
+    void Clear() noexcept {
+        while (size_ != 0) {
+            PopBack();
+        }
+        head_ = 0;
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PushFront(const T& value) {
+        EmplaceFront(value);
+    }
+
+    void PushFront(T&& value) {
+        EmplaceFront(std::move(value));
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            if (overwrite_oldest_) {
+                // the slot of the front item becomes the back one
+                T& item = data_[head_];
+                item = T(std::forward<Args>(args)...);
+                head_ = Wrap(head_ + 1);
+                return item;
+            }
+            Grow(size_, std::forward<Args>(args)...);
+        }
+        else {
+            new (data_ + Wrap(head_ + size_)) T(std::forward<Args>(args)...);
+        }
+        ++size_;
+        return (*this)[size_ - 1];
+    }
+
+    template <typename... Args>
+    T& EmplaceFront(Args&&... args) {
+        if (size_ == Capacity()) {
+            if (overwrite_oldest_) {
+                // the slot of the back item becomes the front one
+                const size_t new_head = Wrap(head_ + Capacity() - 1);
+                T& item = data_[new_head];
+                item = T(std::forward<Args>(args)...);
+                head_ = new_head;
+                return item;
+            }
+            Grow(0, std::forward<Args>(args)...);
+        }
+        else {
+            const size_t new_head = Wrap(head_ + Capacity() - 1);
+            new (data_ + new_head) T(std::forward<Args>(args)...);
+            head_ = new_head;
+        }
+        ++size_;
+        return (*this)[0];
+    }
+
+    void PopBack() noexcept {
+        assert(size_ != 0);
+        --size_;
+        std::destroy_at(data_ + Wrap(head_ + size_));
+    }
+
+    void PopFront() noexcept {
+        assert(size_ != 0);
+        std::destroy_at(data_ + head_);
+        head_ = Wrap(head_ + 1);
+        --size_;
+    }
+
+private:
+    // *this is empty, other is left empty without a buffer; the buffer of other has to be one
+    // that the allocator of *this can free after the move assignment of data_
+    void TakeItems(RingVector& other) noexcept {
+        data_ = std::move(other.data_);
+        head_ = std::exchange(other.head_, 0);
+        size_ = std::exchange(other.size_, 0);
+        overwrite_oldest_ = std::exchange(other.overwrite_oldest_, false);
+    }
+
+    // index is less than twice the capacity
+    size_t Wrap(size_t index) const noexcept {
+        return index >= Capacity() ? index - Capacity() : index;
+    }
+
+    // builds the new item at index of a bigger buffer before the old items move around it,
+    // as args may refer to one of them
+    template <typename... Args>
+    void Grow(size_t index, Args&&... args) {
+        if constexpr (VECTOR_STATS_ENABLED) {
+            ++vector_detail::LocalStats().reallocations;
+        }
+        HeapMemory new_data(GrowthPolicy::NewCapacity(Capacity(), size_ + 1, sizeof(T)), GetAllocator());
+        T* item = new (new_data + index) T(std::forward<Args>(args)...);
+        try {
+            RelocateTo(new_data, index == 0 ? 1 : 0);
+        }
+        catch (...) {
+            std::destroy_at(item);
+            throw;
+        }
+        data_.Swap(new_data);
+        head_ = 0;
+    }
+
+    // moves the items to new_data starting at offset in the order of indices, or copies them
+    // if their move may throw; the old buffer stays untouched if an exception is thrown
+    void RelocateTo(HeapMemory& new_data, size_t offset) {
+        const size_t first_part = std::min(size_, Capacity() - head_);
+        T* to = new_data + offset;
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            if (size_ != 0) {
+                std::memcpy(static_cast<void*>(to), data_ + head_, first_part * sizeof(T));
+                std::memcpy(static_cast<void*>(to + first_part), data_.GetAddress(), (size_ - first_part) * sizeof(T));
+            }
+            if constexpr (VECTOR_STATS_ENABLED) {
+                vector_detail::LocalStats().items_relocated += size_;
+            }
+        }
+        else {
+            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+                std::uninitialized_move_n(data_ + head_, first_part, to);
+                std::uninitialized_move_n(data_.GetAddress(), size_ - first_part, to + first_part);
+                if constexpr (VECTOR_STATS_ENABLED) {
+                    vector_detail::LocalStats().items_moved += size_;
+                }
+            }
+            else {
+                std::uninitialized_copy_n(data_ + head_, first_part, to);
+                try {
+                    std::uninitialized_copy_n(data_.GetAddress(), size_ - first_part, to + first_part);
+                }
+                catch (...) {
+                    std::destroy_n(to, first_part);
+                    throw;
+                }
+                if constexpr (VECTOR_STATS_ENABLED) {
+                    vector_detail::LocalStats().items_copied += size_;
+                }
+            }
+            std::destroy_n(data_ + head_, first_part);
+            std::destroy_n(data_.GetAddress(), size_ - first_part);
+        }
+    }
+
+    HeapMemory data_;
+    // the physical index of the item 0
+    size_t head_ = 0;
+    size_t size_ = 0;
+    bool overwrite_oldest_ = false;
+};
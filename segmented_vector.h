@@ -0,0 +1,412 @@
+#pragma once
+#include "geometric_segments.h"
+#include "vector.h"
+
+#include <iterator>
+
+// vector that grows by adding RawMemory blocks of FIRST_BLOCK_SIZE << k items instead of
+// relocating its items: an append never moves existing items, so pointers and references to them
+// stay valid until they are erased, and the worst case of EmplaceBack is one allocation
+template <typename T, typename Allocator = std::allocator<T>, size_t FIRST_BLOCK_SIZE = 16>
+class SegmentedVector {
+    using AllocTraits = std::allocator_traits<Allocator>;
+    using HeapMemory = RawMemory<T, Allocator>;
+    using Segments = vector_detail::GeometricSegments<FIRST_BLOCK_SIZE>;
+
+    template <bool IS_CONST>
+    class BasicIterator;
+
+public:
+    using allocator_type = Allocator;
+    using value_type = T;
+    using iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true>;
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator(this, size_);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    SegmentedVector() = default;
+
+    explicit SegmentedVector(const Allocator& alloc) noexcept
+        : alloc_(alloc) {
+    }
+
+    explicit SegmentedVector(size_t size, const Allocator& alloc = Allocator())
+        : SegmentedVector(alloc) {
+        Resize(size);
+    }
+
+    SegmentedVector(std::initializer_list<T> items, const Allocator& alloc = Allocator())
+        : SegmentedVector(alloc) {
+        Reserve(items.size());
+        for (const T& item : items) {
+            PushBack(item);
+        }
+    }
+
+    SegmentedVector(const SegmentedVector& other)
+        : SegmentedVector(other, AllocTraits::select_on_container_copy_construction(other.alloc_)) {
+    }
+
+    SegmentedVector(const SegmentedVector& other, const Allocator& alloc)
+        : SegmentedVector(alloc) {
+        Reserve(other.size_);
+        for (const T& item : other) {
+            PushBack(item);
+        }
+    }
+
+    SegmentedVector(SegmentedVector&& other) noexcept
+        : blocks_(std::move(other.blocks_))
+        , size_(std::exchange(other.size_, 0))
+        , alloc_(other.alloc_) {
+    }
+
+    SegmentedVector& operator=(const SegmentedVector& rhs) {
+        if (this != &rhs) {
+            // the blocks of the copy are allocated by the allocator this vector has after the assignment
+            constexpr bool PROPAGATE = AllocTraits::propagate_on_container_copy_assignment::value;
+            SegmentedVector rhs_copy(rhs, PROPAGATE ? rhs.alloc_ : alloc_);
+            Clear();
+            blocks_ = std::move(rhs_copy.blocks_);
+            size_ = std::exchange(rhs_copy.size_, 0);
+            if constexpr (PROPAGATE) {
+                alloc_ = rhs_copy.alloc_;
+            }
+        }
+        return *this;
+    }
+
+    // steals the blocks if they can be freed by the allocator of this vector, otherwise moves the items
+    SegmentedVector& operator=(SegmentedVector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                                              || AllocTraits::is_always_equal::value) {
+        if (this == &rhs) {
+            return *this;
+        }
+        if constexpr (!AllocTraits::propagate_on_container_move_assignment::value
+                      && !AllocTraits::is_always_equal::value) {
+            if (!(alloc_ == rhs.alloc_)) {
+                Clear();
+                Reserve(rhs.size_);
+                for (T& item : rhs) {
+                    PushBack(std::move(item));
+                }
+                return *this;
+            }
+        }
+        Clear();
+        blocks_ = std::move(rhs.blocks_);
+        size_ = std::exchange(rhs.size_, 0);
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            alloc_ = rhs.alloc_;
+        }
+        return *this;
+    }
+
+    ~SegmentedVector() {
+        Clear();
+    }
+
+    void Swap(SegmentedVector& other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            std::swap(alloc_, other.alloc_);
+        }
+        else {
+            assert(alloc_ == other.alloc_);
+        }
+        blocks_.Swap(other.blocks_);
+        std::swap(size_, other.size_);
+    }
+
+    Allocator GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return Segments::SegmentBegin(blocks_.Size());
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return blocks_[Segments::SegmentOf(index)][Segments::OffsetInSegment(index)];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SegmentedVector&>(*this)[index];
+    }
+
+    // adds blocks until capacity items fit, the items stay where they are
+    void Reserve(size_t capacity) {
+        while (Capacity() < capacity) {
+            AddBlock();
+        }
+    }
+
+    // frees the blocks that hold no items
+    void ShrinkToFit() noexcept {
+        while (blocks_.Size() != 0 && Segments::SegmentBegin(blocks_.Size() - 1) >= size_) {
+            blocks_.PopBack();
+        }
+    }
+
+    // destroys the items keeping the blocks
+    void Clear() noexcept {
+        while (size_ != 0) {
+            PopBack();
+        }
+    }
+
+    void Resize(size_t new_size) {
+        Reserve(new_size);
+        while (size_ < new_size) {
+            EmplaceBack();
+        }
+        while (size_ > new_size) {
+            PopBack();
+        }
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        assert(size_ != 0);
+        --size_;
+        std::destroy_at(&SlotAt(size_));
+    }
+
+    // args may refer to an item of the vector as no item moves
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            AddBlock();
+        }
+        T* item = new (&SlotAt(size_)) T(std::forward<Args>(args)...);
+        ++size_;
+        return *item;
+    }
+
+    // the items after pos are shifted by one, so only references to the items before pos stay valid
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        const size_t index = pos - cbegin();
+        assert(index <= size_);
+        if (index == size_) {
+            EmplaceBack(std::forward<Args>(args)...);
+            return begin() + index;
+        }
+        T value(std::forward<Args>(args)...);
+        EmplaceBack(std::move((*this)[size_ - 1]));
+        std::move_backward(begin() + index, end() - 2, end() - 1);
+        (*this)[index] = std::move(value);
+        return begin() + index;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    iterator Erase(const_iterator pos) {
+        return Erase(pos, pos + 1);
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        const size_t index = first - cbegin();
+        const size_t count = last - first;
+        assert(index + count <= size_);
+        std::move(begin() + index + count, end(), begin() + index);
+        for (size_t i = 0; i < count; ++i) {
+            PopBack();
+        }
+        return begin() + index;
+    }
+
+private:
+    // the memory of an item below the capacity
+    T& SlotAt(size_t index) noexcept {
+        return blocks_[Segments::SegmentOf(index)][Segments::OffsetInSegment(index)];
+    }
+
+    void AddBlock() {
+        blocks_.PushBack(HeapMemory(Segments::SegmentSize(blocks_.Size()), alloc_));
+    }
+
+    // block k holds FIRST_BLOCK_SIZE << k items
+    Vector<HeapMemory> blocks_;
+    size_t size_ = 0;
+    Allocator alloc_;
+};
+
+// random access iterator that keeps the position in the current block,
+// so stepping through the items looks up a block only at the block ends
+template <typename T, typename Allocator, size_t FIRST_BLOCK_SIZE>
+template <bool IS_CONST>
+class SegmentedVector<T, Allocator, FIRST_BLOCK_SIZE>::BasicIterator {
+    using Container = std::conditional_t<IS_CONST, const SegmentedVector, SegmentedVector>;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IS_CONST, const T*, T*>;
+    using reference = std::conditional_t<IS_CONST, const T&, T&>;
+
+    BasicIterator() = default;
+
+    // iterator converts to const_iterator
+    template <bool OTHER_CONST, typename = std::enable_if_t<IS_CONST && !OTHER_CONST>>
+    BasicIterator(const BasicIterator<OTHER_CONST>& other) noexcept
+        : BasicIterator(other.container_, other.index_) {
+    }
+
+    reference operator*() const noexcept {
+        assert(item_ != nullptr);
+        return *item_;
+    }
+
+    pointer operator->() const noexcept {
+        return item_;
+    }
+
+    reference operator[](difference_type offset) const noexcept {
+        return (*container_)[index_ + offset];
+    }
+
+    BasicIterator& operator++() noexcept {
+        ++index_;
+        if (++item_ == block_end_) {
+            Locate();
+        }
+        return *this;
+    }
+
+    BasicIterator operator++(int) noexcept {
+        BasicIterator old = *this;
+        ++*this;
+        return old;
+    }
+
+    BasicIterator& operator--() noexcept {
+        return *this -= 1;
+    }
+
+    BasicIterator operator--(int) noexcept {
+        BasicIterator old = *this;
+        --*this;
+        return old;
+    }
+
+    BasicIterator& operator+=(difference_type offset) noexcept {
+        index_ += offset;
+        Locate();
+        return *this;
+    }
+
+    BasicIterator& operator-=(difference_type offset) noexcept {
+        return *this += -offset;
+    }
+
+    friend BasicIterator operator+(BasicIterator it, difference_type offset) noexcept {
+        return it += offset;
+    }
+
+    friend BasicIterator operator+(difference_type offset, BasicIterator it) noexcept {
+        return it += offset;
+    }
+
+    friend BasicIterator operator-(BasicIterator it, difference_type offset) noexcept {
+        return it -= offset;
+    }
+
+    friend difference_type operator-(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+    }
+
+    friend bool operator==(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return lhs.index_ == rhs.index_;
+    }
+
+    friend bool operator!=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return lhs.index_ != rhs.index_;
+    }
+
+    friend bool operator<(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return lhs.index_ < rhs.index_;
+    }
+
+    friend bool operator>(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return rhs < lhs;
+    }
+
+    friend bool operator<=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return !(rhs < lhs);
+    }
+
+    friend bool operator>=(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return !(lhs < rhs);
+    }
+
+private:
+    friend class SegmentedVector;
+
+    template <bool OTHER_CONST>
+    friend class BasicIterator;
+
+    BasicIterator(Container* container, size_t index) noexcept
+        : container_(container)
+        , index_(index) {
+        Locate();
+    }
+
+    // end() and positions past the blocks have no item
+    void Locate() noexcept {
+        if (index_ >= container_->Capacity()) {
+            item_ = nullptr;
+            block_end_ = nullptr;
+            return;
+        }
+        const size_t block = Segments::SegmentOf(index_);
+        auto& memory = container_->blocks_[block];
+        item_ = memory + Segments::OffsetInSegment(index_);
+        block_end_ = memory + Segments::SegmentSize(block);
+    }
+
+    Container* container_ = nullptr;
+    size_t index_ = 0;
+    pointer item_ = nullptr;
+    pointer block_end_ = nullptr;
+};
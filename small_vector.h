@@ -0,0 +1,110 @@
+#pragma once
+#include "vector.h"
+
+// storage for Vector that keeps up to N items inside the object and moves to the heap
+// when a bigger buffer is swapped in; it is inline as long as no heap buffer is owned
+template <typename T, size_t N, typename Allocator = std::allocator<T>>
+class InlineRawMemory {
+    static_assert(N != 0, "use RawMemory if no inline items are needed");
+
+public:
+    using allocator_type = Allocator;
+
+    static constexpr size_t INLINE_CAPACITY = N;
+
+    InlineRawMemory() = default;
+
+    explicit InlineRawMemory(const Allocator& alloc) noexcept
+        : heap_(alloc) {
+    }
+
+    explicit InlineRawMemory(size_t capacity, const Allocator& alloc = Allocator())
+        : heap_(capacity > N ? capacity : 0, alloc) {
+    }
+
+    InlineRawMemory(const InlineRawMemory&) = delete;
+
+    InlineRawMemory& operator=(const InlineRawMemory&) = delete;
+
+    // only a heap buffer is handed over, inline items have to be relocated by the owner
+    InlineRawMemory(InlineRawMemory&& other) noexcept
+        : heap_(std::move(other.heap_)) {
+    }
+
+    InlineRawMemory& operator=(InlineRawMemory&& rhs) noexcept {
+        heap_ = std::move(rhs.heap_);
+        return *this;
+    }
+
+    T* operator+(size_t offset) noexcept {
+        assert(offset <= Capacity());
+        vector_detail::HardeningCheck(offset <= Capacity(), "InlineRawMemory offset is out of range");
+        return GetAddress() + offset;
+    }
+
+    const T* operator+(size_t offset) const noexcept {
+        return const_cast<InlineRawMemory&>(*this) + offset;
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < Capacity());
+        vector_detail::HardeningCheck(index < Capacity(), "InlineRawMemory index is out of range");
+        return GetAddress()[index];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<InlineRawMemory&>(*this)[index];
+    }
+
+    // valid only if both buffers are on the heap
+    void Swap(InlineRawMemory& other) noexcept {
+        assert(!IsInline() && !other.IsInline());
+        heap_.Swap(other.heap_);
+    }
+
+    // takes over the heap buffer of other, an empty other brings the storage back to the inline buffer
+    void Swap(RawMemory<T, Allocator>& other) noexcept {
+        heap_.Swap(other);
+    }
+
+    void Reallocate(size_t new_capacity) {
+        assert(!IsInline());
+        heap_.Reallocate(new_capacity);
+    }
+
+    void ResetAllocator(const Allocator& alloc) noexcept {
+        heap_.ResetAllocator(alloc);
+    }
+
+    bool HasEqualAllocator(const InlineRawMemory& other) const noexcept {
+        return heap_.HasEqualAllocator(other.heap_);
+    }
+
+    const Allocator& GetAllocator() const noexcept {
+        return heap_.GetAllocator();
+    }
+
+    T* GetAddress() noexcept {
+        return IsInline() ? std::launder(reinterpret_cast<T*>(inline_buffer_)) : heap_.GetAddress();
+    }
+
+    const T* GetAddress() const noexcept {
+        return const_cast<InlineRawMemory&>(*this).GetAddress();
+    }
+
+    size_t Capacity() const {
+        return IsInline() ? N : heap_.Capacity();
+    }
+
+    bool IsInline() const noexcept {
+        return heap_.GetAddress() == nullptr;
+    }
+
+private:
+    RawMemory<T, Allocator> heap_;
+    alignas(T) unsigned char inline_buffer_[N * sizeof(T)];
+};
+
+// Vector that doesn't allocate memory while it holds no more than N items
+template <typename T, size_t N, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth>
+using SmallVector = Vector<T, Allocator, GrowthPolicy, InlineRawMemory<T, N, Allocator>>;
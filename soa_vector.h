@@ -0,0 +1,308 @@
+#pragma once
+#include "index_iterator.h"
+#include "vector.h"
+
+#include <tuple>
+
+// contiguous items of one column of SoaVector, valid until the vector changes its size or capacity
+template <typename T>
+class ColumnSpan {
+public:
+    using value_type = std::remove_const_t<T>;
+    using iterator = T*;
+
+    ColumnSpan(T* data, size_t size) noexcept
+        : data_(data)
+        , size_(size) {
+    }
+
+    T* begin() const noexcept {
+        return data_;
+    }
+
+    T* end() const noexcept {
+        return data_ + size_;
+    }
+
+    T* Data() const noexcept {
+        return data_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return data_[index];
+    }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// vector of rows whose fields are stored in separate columns, so a scan of one field reads only
+// the memory of that field. All columns have the same capacity and grow together by GrowthPolicy,
+// which gets the size of a whole row. A row is seen as a tuple of references to its fields
+template <typename GrowthPolicy, typename... Fields>
+class BasicSoaVector {
+    static_assert(sizeof...(Fields) != 0);
+
+    using Columns = std::tuple<RawMemory<Fields>...>;
+    using FieldIndices = std::index_sequence_for<Fields...>;
+
+    static constexpr size_t ROW_SIZE = (sizeof(Fields) + ...);
+
+    // columns whose items may throw on move are copied to a new buffer
+    template <typename T>
+    static constexpr bool IS_COPIED_ON_GROWTH = !IsTriviallyRelocatableV<T> && !std::is_nothrow_move_constructible_v<T>;
+
+public:
+    using value_type = std::tuple<Fields...>;
+    using Row = std::tuple<Fields&...>;
+    using ConstRow = std::tuple<const Fields&...>;
+    using iterator = vector_detail::IndexIterator<BasicSoaVector, false>;
+    using const_iterator = vector_detail::IndexIterator<BasicSoaVector, true>;
+
+    template <size_t I>
+    using FieldType = std::tuple_element_t<I, value_type>;
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator(this, size_);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+    BasicSoaVector() = default;
+
+    BasicSoaVector(const BasicSoaVector& other)
+        : BasicSoaVector() {
+        Reserve(other.size_);
+        for (size_t index = 0; index < other.size_; ++index) {
+            std::apply([this](const Fields&... fields) {
+                EmplaceBack(fields...);
+            }, other[index]);
+        }
+    }
+
+    BasicSoaVector(BasicSoaVector&& other) noexcept
+        : columns_(std::move(other.columns_))
+        , size_(std::exchange(other.size_, 0)) {
+    }
+
+    BasicSoaVector& operator=(const BasicSoaVector& rhs) {
+        if (this != &rhs) {
+            BasicSoaVector rhs_copy(rhs);
+            Swap(rhs_copy);
+        }
+        return *this;
+    }
+
+    BasicSoaVector& operator=(BasicSoaVector&& rhs) noexcept {
+        if (this != &rhs) {
+            BasicSoaVector rhs_moved(std::move(rhs));
+            Swap(rhs_moved);
+        }
+        return *this;
+    }
+
+    ~BasicSoaVector() {
+        Clear();
+    }
+
+    void Swap(BasicSoaVector& other) noexcept {
+        SwapColumns(columns_, other.columns_, FieldIndices{});
+        std::swap(size_, other.size_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return std::get<0>(columns_).Capacity();
+    }
+
+    Row operator[](size_t index) noexcept {
+        assert(index < size_);
+        return RowAt(index, FieldIndices{});
+    }
+
+    ConstRow operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return const_cast<BasicSoaVector&>(*this).RowAt(index, FieldIndices{});
+    }
+
+    // the items of field I of all rows, e.g. for a SIMD scan
+    template <size_t I>
+    ColumnSpan<FieldType<I>> Column() noexcept {
+        return { std::get<I>(columns_).GetAddress(), size_ };
+    }
+
+    template <size_t I>
+    ColumnSpan<const FieldType<I>> Column() const noexcept {
+        return { std::get<I>(columns_).GetAddress(), size_ };
+    }
+
+    void Reserve(size_t capacity) {
+        if (capacity > Capacity()) {
+            Columns new_columns(MakeColumns(capacity));
+            RelocateColumns(new_columns, FieldIndices{});
+            SwapColumns(columns_, new_columns, FieldIndices{});
+        }
+    }
+
+    void Clear() noexcept {
+        while (size_ != 0) {
+            PopBack();
+        }
+    }
+
+    void PopBack() noexcept {
+        assert(size_ != 0);
+        --size_;
+        DestroyRow(columns_, size_, FieldIndices{});
+    }
+
+    // builds one field from each argument; if an exception is thrown the vector stays untouched,
+    // args may refer to the fields of some row as the new row is built before the old rows move
+    template <typename... Args>
+    Row EmplaceBack(Args&&... args) {
+        static_assert(sizeof...(Args) == sizeof...(Fields), "one argument per field");
+        if (size_ == Capacity()) {
+            if constexpr (VECTOR_STATS_ENABLED) {
+                ++vector_detail::LocalStats().reallocations;
+            }
+            Columns new_columns(MakeColumns(GrowthPolicy::NewCapacity(Capacity(), size_ + 1, ROW_SIZE)));
+            ConstructRow(new_columns, size_, FieldIndices{}, std::forward<Args>(args)...);
+            try {
+                RelocateColumns(new_columns, FieldIndices{});
+            }
+            catch (...) {
+                DestroyRow(new_columns, size_, FieldIndices{});
+                throw;
+            }
+            SwapColumns(columns_, new_columns, FieldIndices{});
+        }
+        else {
+            ConstructRow(columns_, size_, FieldIndices{}, std::forward<Args>(args)...);
+        }
+        ++size_;
+        return (*this)[size_ - 1];
+    }
+
+private:
+    template <size_t... I>
+    Row RowAt(size_t index, std::index_sequence<I...>) noexcept {
+        return Row(std::get<I>(columns_)[index]...);
+    }
+
+    static Columns MakeColumns(size_t capacity) {
+        return Columns(RawMemory<Fields>(capacity)...);
+    }
+
+    template <size_t... I>
+    static void SwapColumns(Columns& lhs, Columns& rhs, std::index_sequence<I...>) noexcept {
+        (std::get<I>(lhs).Swap(std::get<I>(rhs)), ...);
+    }
+
+    // builds all fields of the row at index or none of them
+    template <size_t... I, typename... Args>
+    static void ConstructRow(Columns& columns, size_t index, std::index_sequence<I...>, Args&&... args) {
+        size_t built = 0;
+        try {
+            ((new (std::get<I>(columns) + index) Fields(std::forward<Args>(args)), ++built), ...);
+        }
+        catch (...) {
+            ((I < built ? std::destroy_at(std::get<I>(columns) + index) : void()), ...);
+            throw;
+        }
+    }
+
+    template <size_t... I>
+    static void DestroyRow(Columns& columns, size_t index, std::index_sequence<I...>) noexcept {
+        (std::destroy_at(std::get<I>(columns) + index), ...);
+    }
+
+    // moves the rows to new_columns; the columns that may throw are copied first, so until all of them
+    // are copied the old rows are untouched and an exception leaves the vector as it was
+    template <size_t... I>
+    void RelocateColumns(Columns& new_columns, std::index_sequence<I...>) {
+        size_t column = 0;
+        try {
+            ((CopyColumn<I>(new_columns), ++column), ...);
+        }
+        catch (...) {
+            (DestroyCopiedColumn<I>(new_columns, column), ...);
+            throw;
+        }
+        (MoveColumn<I>(new_columns), ...);
+        (DestroyOldColumn<I>(), ...);
+    }
+
+    template <size_t I>
+    void CopyColumn(Columns& new_columns) {
+        if constexpr (IS_COPIED_ON_GROWTH<FieldType<I>>) {
+            std::uninitialized_copy_n(std::get<I>(columns_).GetAddress(), size_, std::get<I>(new_columns).GetAddress());
+            if constexpr (VECTOR_STATS_ENABLED) {
+                vector_detail::LocalStats().items_copied += size_;
+            }
+        }
+    }
+
+    // the copies of the columns before failed_column are destroyed, the failed one cleans up itself
+    template <size_t I>
+    void DestroyCopiedColumn(Columns& new_columns, size_t failed_column) noexcept {
+        if constexpr (IS_COPIED_ON_GROWTH<FieldType<I>>) {
+            if (I < failed_column) {
+                std::destroy_n(std::get<I>(new_columns).GetAddress(), size_);
+            }
+        }
+    }
+
+    template <size_t I>
+    void MoveColumn(Columns& new_columns) noexcept {
+        using T = FieldType<I>;
+        T* from = std::get<I>(columns_).GetAddress();
+        T* to = std::get<I>(new_columns).GetAddress();
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            if (size_ != 0) {
+                std::memcpy(static_cast<void*>(to), from, size_ * sizeof(T));
+            }
+            if constexpr (VECTOR_STATS_ENABLED) {
+                vector_detail::LocalStats().items_relocated += size_;
+            }
+        }
+        else if constexpr (!IS_COPIED_ON_GROWTH<T>) {
+            std::uninitialized_move_n(from, size_, to);
+            if constexpr (VECTOR_STATS_ENABLED) {
+                vector_detail::LocalStats().items_moved += size_;
+            }
+        }
+    }
+
+    // relocated items are not destroyed, moved-from and copied ones are
+    template <size_t I>
+    void DestroyOldColumn() noexcept {
+        if constexpr (!IsTriviallyRelocatableV<FieldType<I>>) {
+            std::destroy_n(std::get<I>(columns_).GetAddress(), size_);
+        }
+    }
+
+    Columns columns_;
+    size_t size_ = 0;
+};
+
+template <typename... Fields>
+using SoaVector = BasicSoaVector<DoublingGrowth, Fields...>;
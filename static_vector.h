@@ -0,0 +1,301 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace vector_detail {
+
+    // items of trivial types live in an array, so a StaticVector of them can be built and changed
+    // in constant expressions, which can't leave a part of the array uninitialized. With
+    // std::is_constant_evaluated (C++20) the array is zeroed only there; under C++17 every creation
+    // of the vector zeroes all N items, an O(N) cost whatever the size. Copies take the items only
+    template <typename T, size_t N, bool IS_TRIVIAL = std::is_trivial_v<T>>
+    class StaticStorage {
+    protected:
+#if defined(__cpp_lib_is_constant_evaluated)
+        constexpr StaticStorage() noexcept {
+            if (std::is_constant_evaluated()) {
+                for (size_t i = 0; i < N; ++i) {
+                    items_[i] = T();
+                }
+            }
+        }
+#else
+        StaticStorage() = default;
+#endif
+
+        constexpr StaticStorage(const StaticStorage& other) noexcept
+            : StaticStorage() {
+            CopyItems(other);
+        }
+
+        constexpr StaticStorage& operator=(const StaticStorage& rhs) noexcept {
+            CopyItems(rhs);
+            return *this;
+        }
+
+        constexpr T* Items() noexcept {
+            return items_;
+        }
+
+        constexpr const T* Items() const noexcept {
+            return items_;
+        }
+
+        template <typename... Args>
+        constexpr T& Construct(size_t index, Args&&... args) {
+            items_[index] = T(std::forward<Args>(args)...);
+            return items_[index];
+        }
+
+        constexpr void Destroy(size_t /*index*/) noexcept {
+        }
+
+        size_t size_ = 0;
+
+    private:
+        constexpr void CopyItems(const StaticStorage& other) noexcept {
+            for (size_t i = 0; i < other.size_; ++i) {
+                items_[i] = other.items_[i];
+            }
+            size_ = other.size_;
+        }
+
+#if defined(__cpp_lib_is_constant_evaluated)
+        T items_[N];
+#else
+        T items_[N] = {};
+#endif
+    };
+
+    // other items are built with placement new in raw memory
+    template <typename T, size_t N>
+    class StaticStorage<T, N, false> {
+    protected:
+        StaticStorage() = default;
+
+        StaticStorage(const StaticStorage& other)
+            : size_(0) {
+            std::uninitialized_copy_n(other.Items(), other.size_, Items());
+            size_ = other.size_;
+        }
+
+        StaticStorage(StaticStorage&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : size_(0) {
+            std::uninitialized_move_n(other.Items(), other.size_, Items());
+            size_ = other.size_;
+        }
+
+        StaticStorage& operator=(const StaticStorage& rhs) {
+            if (this != &rhs) {
+                Assign(rhs.Items(), rhs.size_);
+            }
+            return *this;
+        }
+
+        StaticStorage& operator=(StaticStorage&& rhs) noexcept(std::is_nothrow_move_assignable_v<T>
+                                                               && std::is_nothrow_move_constructible_v<T>) {
+            if (this != &rhs) {
+                Assign(std::make_move_iterator(rhs.Items()), rhs.size_);
+            }
+            return *this;
+        }
+
+        ~StaticStorage() {
+            std::destroy_n(Items(), size_);
+        }
+
+        T* Items() noexcept {
+            return std::launder(reinterpret_cast<T*>(bytes_));
+        }
+
+        const T* Items() const noexcept {
+            return const_cast<StaticStorage&>(*this).Items();
+        }
+
+        template <typename... Args>
+        T& Construct(size_t index, Args&&... args) {
+            return *new (Items() + index) T(std::forward<Args>(args)...);
+        }
+
+        void Destroy(size_t index) noexcept {
+            std::destroy_at(Items() + index);
+        }
+
+        size_t size_ = 0;
+
+    private:
+        // assigns to the common items and then builds or destroys the rest
+        template <typename InputIt>
+        void Assign(InputIt from, size_t count) {
+            const size_t common = std::min(size_, count);
+            std::copy_n(from, common, Items());
+            if (count < size_) {
+                std::destroy_n(Items() + count, size_ - count);
+            }
+            else {
+                std::uninitialized_copy_n(from + common, count - common, Items() + common);
+            }
+            size_ = count;
+        }
+
+        alignas(T) unsigned char bytes_[N * sizeof(T)];
+    };
+
+}  // namespace vector_detail
+
+// vector of at most N items kept inside the object: nothing is allocated and adding an item
+// is not preceded by a capacity check, overflowing the capacity is caught by an assert only.
+// A StaticVector of trivial items can be used in constant expressions, e.g. to build lookup tables
+template <typename T, size_t N>
+class StaticVector : private vector_detail::StaticStorage<T, N> {
+    static_assert(N != 0);
+
+    using Storage = vector_detail::StaticStorage<T, N>;
+    using Storage::Construct;
+    using Storage::Destroy;
+    using Storage::Items;
+    using Storage::size_;
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_t CAPACITY = N;
+
+    StaticVector() = default;
+
+    constexpr explicit StaticVector(size_t size) {
+        Resize(size);
+    }
+
+    constexpr StaticVector(std::initializer_list<T> items) {
+        for (const T& item : items) {
+            PushBack(item);
+        }
+    }
+
+    constexpr iterator begin() noexcept {
+        return Items();
+    }
+
+    constexpr iterator end() noexcept {
+        return Items() + size_;
+    }
+
+    constexpr const_iterator begin() const noexcept {
+        return Items();
+    }
+
+    constexpr const_iterator end() const noexcept {
+        return Items() + size_;
+    }
+
+    constexpr const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    constexpr const_iterator cend() const noexcept {
+        return end();
+    }
+
+    constexpr size_t Size() const noexcept {
+        return size_;
+    }
+
+    static constexpr size_t Capacity() noexcept {
+        return N;
+    }
+
+    constexpr T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return Items()[index];
+    }
+
+    constexpr const T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return Items()[index];
+    }
+
+    // new items are value-initialized
+    constexpr void Resize(size_t new_size) {
+        assert(new_size <= N);
+        while (size_ > new_size) {
+            PopBack();
+        }
+        while (size_ < new_size) {
+            EmplaceBack();
+        }
+    }
+
+    constexpr void Clear() noexcept {
+        while (size_ != 0) {
+            PopBack();
+        }
+    }
+
+    constexpr void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    constexpr void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    template <typename... Args>
+    constexpr T& EmplaceBack(Args&&... args) {
+        assert(size_ < N);
+        T& item = Construct(size_, std::forward<Args>(args)...);
+        ++size_;
+        return item;
+    }
+
+    constexpr void PopBack() noexcept {
+        assert(size_ != 0);
+        --size_;
+        Destroy(size_);
+    }
+
+    // shifts the tail by one move per item, the new item is built before as args may refer to an item
+    template <typename... Args>
+    constexpr iterator Emplace(const_iterator pos, Args&&... args) {
+        const size_t index = static_cast<size_t>(pos - cbegin());
+        assert(index <= size_);
+        if (index == size_) {
+            EmplaceBack(std::forward<Args>(args)...);
+        }
+        else {
+            T value(std::forward<Args>(args)...);
+            EmplaceBack(std::move(Items()[size_ - 1]));
+            for (size_t i = size_ - 2; i > index; --i) {
+                Items()[i] = std::move(Items()[i - 1]);
+            }
+            Items()[index] = std::move(value);
+        }
+        return begin() + index;
+    }
+
+    constexpr iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    constexpr iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    constexpr iterator Erase(const_iterator pos) {
+        const size_t index = static_cast<size_t>(pos - cbegin());
+        assert(index < size_);
+        for (size_t i = index; i + 1 < size_; ++i) {
+            Items()[i] = std::move(Items()[i + 1]);
+        }
+        PopBack();
+        return begin() + index;
+    }
+};
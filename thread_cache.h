@@ -0,0 +1,199 @@
+#pragma once
+#include "vector.h"
+
+#include <atomic>
+
+// Per-thread cache of freed buffers of CachingAllocator. Buffers of up to MAX_CACHED_BLOCK bytes are
+// rounded up to a power of two, and a freed buffer is kept in the free list of its size class
+// of the freeing thread, so a vector created after one is destroyed takes the buffer without
+// a call to the heap and without touching state shared with other threads. Each thread keeps at
+// most the budget set with SetThreadCacheBudget and frees its cached buffers when it exits
+
+struct ThreadCacheStats {
+    // allocations served from the cache and by operator new
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t cached_bytes = 0;
+};
+
+namespace vector_detail {
+
+    inline constexpr size_t MIN_CACHED_BLOCK = 64;
+    inline constexpr size_t NUM_SIZE_CLASSES = 15;
+    inline constexpr size_t MAX_CACHED_BLOCK = MIN_CACHED_BLOCK << (NUM_SIZE_CLASSES - 1);
+
+    inline std::atomic<size_t> thread_cache_budget{ size_t{ 4 } << 20 };
+
+    // the smallest size class whose blocks hold bytes, bytes must not exceed MAX_CACHED_BLOCK
+    inline size_t SizeClassOf(size_t bytes) noexcept {
+        size_t size_class = 0;
+        while ((MIN_CACHED_BLOCK << size_class) < bytes) {
+            ++size_class;
+        }
+        return size_class;
+    }
+
+    inline size_t SizeClassBytes(size_t size_class) noexcept {
+        return MIN_CACHED_BLOCK << size_class;
+    }
+
+    // the cache is gone once the destructor of the thread's cache has run; buffers freed later
+    // during the exit of the thread, e.g. by other thread_local objects, go straight to the heap
+    inline thread_local bool thread_cache_destroyed = false;
+
+    class ThreadCache {
+    public:
+        ThreadCache() = default;
+
+        ThreadCache(const ThreadCache&) = delete;
+
+        ThreadCache& operator=(const ThreadCache&) = delete;
+
+        ~ThreadCache() {
+            Trim(0);
+            thread_cache_destroyed = true;
+        }
+
+        void* Allocate(size_t size_class) {
+            if (FreeBlock* block = free_lists_[size_class]) {
+                free_lists_[size_class] = block->next;
+                stats_.cached_bytes -= SizeClassBytes(size_class);
+                ++stats_.hits;
+                return block;
+            }
+            ++stats_.misses;
+            return ::operator new(SizeClassBytes(size_class));
+        }
+
+        void Deallocate(void* ptr, size_t size_class) noexcept {
+            const size_t bytes = SizeClassBytes(size_class);
+            if (stats_.cached_bytes + bytes > thread_cache_budget.load(std::memory_order_relaxed)) {
+                ::operator delete(ptr, bytes);
+                return;
+            }
+            free_lists_[size_class] = new (ptr) FreeBlock{ free_lists_[size_class] };
+            stats_.cached_bytes += bytes;
+        }
+
+        // frees cached blocks, the biggest ones first, until no more than max_bytes are cached
+        void Trim(size_t max_bytes) noexcept {
+            for (size_t size_class = NUM_SIZE_CLASSES; size_class-- > 0 && stats_.cached_bytes > max_bytes;) {
+                while (free_lists_[size_class] != nullptr && stats_.cached_bytes > max_bytes) {
+                    FreeBlock* block = free_lists_[size_class];
+                    free_lists_[size_class] = block->next;
+                    stats_.cached_bytes -= SizeClassBytes(size_class);
+                    ::operator delete(static_cast<void*>(block), SizeClassBytes(size_class));
+                }
+            }
+        }
+
+        const ThreadCacheStats& Stats() const noexcept {
+            return stats_;
+        }
+
+        void ResetCounters() noexcept {
+            stats_.hits = 0;
+            stats_.misses = 0;
+        }
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        FreeBlock* free_lists_[NUM_SIZE_CLASSES] = {};
+        ThreadCacheStats stats_;
+    };
+
+    inline ThreadCache& LocalThreadCache() noexcept {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+}  // namespace vector_detail
+
+// the most bytes of freed buffers each thread keeps, 4 MB by default; 0 turns the caching off
+inline void SetThreadCacheBudget(size_t bytes) noexcept {
+    vector_detail::thread_cache_budget.store(bytes, std::memory_order_relaxed);
+}
+
+// the counters of the current thread
+inline ThreadCacheStats GetThreadCacheStats() noexcept {
+    return vector_detail::thread_cache_destroyed ? ThreadCacheStats{} : vector_detail::LocalThreadCache().Stats();
+}
+
+inline void ResetThreadCacheStats() noexcept {
+    if (!vector_detail::thread_cache_destroyed) {
+        vector_detail::LocalThreadCache().ResetCounters();
+    }
+}
+
+// frees the buffers cached by the current thread
+inline void TrimThreadCache() noexcept {
+    if (!vector_detail::thread_cache_destroyed) {
+        vector_detail::LocalThreadCache().Trim(0);
+    }
+}
+
+// allocator that takes buffers from the cache of the current thread, worth it for many short-lived
+// vectors of similar sizes; buffers bigger than MAX_CACHED_BLOCK come from operator new directly.
+// A buffer may be freed by another thread than the one that allocated it
+template <typename T>
+struct CachingAllocator {
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "operator new doesn't support the alignment of T");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    CachingAllocator() = default;
+
+    template <typename U>
+    CachingAllocator(const CachingAllocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        return allocate_at_least(n).ptr;
+    }
+
+    // the capacity fills the block of the size class
+    AllocationResult<T> allocate_at_least(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        const size_t bytes = n * sizeof(T);
+        if (bytes > vector_detail::MAX_CACHED_BLOCK) {
+            return { static_cast<T*>(::operator new(bytes)), n };
+        }
+        const size_t size_class = vector_detail::SizeClassOf(bytes);
+        const size_t count = vector_detail::SizeClassBytes(size_class) / sizeof(T);
+        if (vector_detail::thread_cache_destroyed) {
+            return { static_cast<T*>(::operator new(vector_detail::SizeClassBytes(size_class))), count };
+        }
+        return { static_cast<T*>(vector_detail::LocalThreadCache().Allocate(size_class)), count };
+    }
+
+    // n may be the requested number of items or the count that allocate_at_least returned,
+    // both give the same size class
+    void deallocate(T* ptr, size_t n) noexcept {
+        const size_t bytes = n * sizeof(T);
+        if (bytes > vector_detail::MAX_CACHED_BLOCK) {
+            ::operator delete(static_cast<void*>(ptr), bytes);
+        }
+        else if (vector_detail::thread_cache_destroyed) {
+            ::operator delete(static_cast<void*>(ptr), vector_detail::SizeClassBytes(vector_detail::SizeClassOf(bytes)));
+        }
+        else {
+            vector_detail::LocalThreadCache().Deallocate(static_cast<void*>(ptr), vector_detail::SizeClassOf(bytes));
+        }
+    }
+
+    template <typename U>
+    bool operator==(const CachingAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CachingAllocator<U>&) const noexcept {
+        return false;
+    }
+};
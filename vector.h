@@ -1,18 +1,199 @@
 #pragma once
 #include <cassert>
+#include <cstddef>
 #include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
 #include <new>
 #include <utility>
 #include <memory>
 #include <algorithm>
+#include <type_traits>
 
+#include "vector_hardening.h"
+#include "vector_parallel.h"
+#include "vector_stats.h"
+#include "vector_trace.h"
+
+#if defined(VECTOR_USE_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+// tells that objects of T may be moved to another address with memcpy, skipping the move constructor
+// and the destructor of the source; specialize it as std::true_type for such types
+template <typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {
+};
+
+template <typename T>
+inline constexpr bool IsTriviallyRelocatableV = IsTriviallyRelocatable<T>::value;
+
+// allocator on top of malloc that can also grow a buffer in place with realloc;
+// glibc remaps huge blocks with mremap and jemalloc tries to extend them with xallocx
+// inside realloc, so no copying happens in these cases
+template <typename T>
+struct MallocAllocator {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "malloc doesn't support the alignment of T");
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    MallocAllocator() = default;
+
+    template <typename U>
+    MallocAllocator(const MallocAllocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        void* ptr = std::malloc(n * sizeof(T));
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t /*n*/) noexcept {
+        std::free(ptr);
+    }
+
+    // resizes the block keeping its bytes, the block stays valid if an exception is thrown
+    T* reallocate(T* ptr, size_t /*old_n*/, size_t new_n) {
+        void* new_ptr = std::realloc(static_cast<void*>(ptr), new_n * sizeof(T));
+        if (new_ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(new_ptr);
+    }
+
+    template <typename U>
+    bool operator==(const MallocAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const MallocAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+
+// the result of allocate_at_least: the buffer and the number of items it can hold
+template <typename T>
+struct AllocationResult {
+    T* ptr = nullptr;
+    size_t count = 0;
+};
+
+// a buffer given up by Vector::Release: size constructed items and room for capacity items
 template <typename T>
-class RawMemory {
+struct ReleasedBuffer {
+    T* ptr = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+};
+
+// allocator that aligns buffers to ALIGNMENT bytes, e.g. for aligned SIMD loads;
+// if PAD_TO_ALIGNMENT is set the capacity is rounded up to fill the last ALIGNMENT bytes,
+// so buffers with a cache line alignment never share cache lines with other data
+template <typename T, size_t ALIGNMENT = CACHE_LINE_SIZE, bool PAD_TO_ALIGNMENT = false>
+struct AlignedAllocator {
+    static_assert((ALIGNMENT & (ALIGNMENT - 1)) == 0, "the alignment must be a power of two");
+
+    static constexpr size_t BUFFER_ALIGNMENT = std::max(ALIGNMENT, alignof(T));
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, ALIGNMENT, PAD_TO_ALIGNMENT>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, ALIGNMENT, PAD_TO_ALIGNMENT>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        return allocate_at_least(n).ptr;
+    }
+
+    AllocationResult<T> allocate_at_least(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T) - BUFFER_ALIGNMENT) {
+            throw std::bad_array_new_length();
+        }
+        size_t bytes = n * sizeof(T);
+        if constexpr (PAD_TO_ALIGNMENT) {
+            bytes = (bytes + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+        }
+        void* ptr = ::operator new(bytes, std::align_val_t{ BUFFER_ALIGNMENT });
+        return { static_cast<T*>(ptr), bytes / sizeof(T) };
+    }
+
+    void deallocate(T* ptr, size_t /*n*/) noexcept {
+        ::operator delete(ptr, std::align_val_t{ BUFFER_ALIGNMENT });
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, ALIGNMENT, PAD_TO_ALIGNMENT>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, ALIGNMENT, PAD_TO_ALIGNMENT>&) const noexcept {
+        return false;
+    }
+};
+
+// true if the allocator has AllocationResult<T> allocate_at_least(size_t n), as in C++23
+template <typename Allocator, typename = void>
+struct HasAllocateAtLeast : std::false_type {
+};
+
+template <typename Allocator>
+struct HasAllocateAtLeast<Allocator, std::void_t<decltype(std::declval<Allocator&>().allocate_at_least(size_t{}))>>
+    : std::true_type {
+};
+
+// true if the allocator has T* reallocate(T* ptr, size_t old_n, size_t new_n)
+template <typename Allocator, typename = void>
+struct HasReallocate : std::false_type {
+};
+
+template <typename Allocator>
+struct HasReallocate<Allocator, std::void_t<decltype(std::declval<Allocator&>().reallocate(
+    std::declval<typename Allocator::value_type*>(), size_t{}, size_t{}))>> : std::true_type {
+};
+
+template <typename T, typename Allocator = std::allocator<T>>
+class RawMemory : private Allocator {
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+    static_assert(std::is_same_v<typename AllocTraits::value_type, T>, "Allocator::value_type must be T");
+    static_assert(std::is_same_v<typename AllocTraits::pointer, T*>, "fancy pointers are not supported");
+
 public:
+    using allocator_type = Allocator;
+
+    // number of items that fit into the object itself without a heap allocation
+    static constexpr size_t INLINE_CAPACITY = 0;
+
     RawMemory() = default;
 
-    explicit RawMemory(size_t capacity)
-        : buffer_(Allocate(capacity))
+    explicit RawMemory(const Allocator& alloc) noexcept
+        : Allocator(alloc) {
+    }
+
+    // Allocate may round the capacity up before capacity_ is initialized with it
+    explicit RawMemory(size_t capacity, const Allocator& alloc = Allocator())
+        : Allocator(alloc)
+        , buffer_(Allocate(capacity))
         , capacity_(capacity) {
     }
 
@@ -20,25 +201,34 @@ public:
 
     RawMemory& operator=(const RawMemory&) = delete;
 
-    RawMemory(RawMemory&& other) noexcept {
-		Deallocate(buffer_);
-		buffer_ = std::exchange(other.buffer_, nullptr);
-		capacity_ = std::exchange(other.capacity_, 0);
+    RawMemory(RawMemory&& other) noexcept
+        : Allocator(std::move(other.Alloc()))
+        , buffer_(std::exchange(other.buffer_, nullptr))
+        , capacity_(std::exchange(other.capacity_, 0)) {
     }
 
+    // the caller has to make sure that the buffer of rhs can be freed by the allocator of *this
+    // after the assignment, i.e. that the allocator propagates or the allocators are equal
     RawMemory& operator=(RawMemory&& rhs) noexcept {
-		Deallocate(buffer_);
+        Deallocate(buffer_, capacity_);
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            Alloc() = std::move(rhs.Alloc());
+        }
+        else {
+            assert(HasEqualAllocator(rhs));
+        }
         buffer_ = std::exchange(rhs.buffer_, nullptr);
         capacity_ = std::exchange(rhs.capacity_, 0);
         return *this;
     }
 
     ~RawMemory() {
-        Deallocate(buffer_);
+        Deallocate(buffer_, capacity_);
     }
 
     T* operator+(size_t offset) noexcept {
         assert(offset <= capacity_);
+        vector_detail::HardeningCheck(offset <= capacity_, "RawMemory offset is out of range");
         return buffer_ + offset;
     }
 
@@ -48,6 +238,7 @@ public:
 
     T& operator[](size_t index) noexcept {
         assert(index < capacity_);
+        vector_detail::HardeningCheck(index < capacity_, "RawMemory index is out of range");
         return buffer_[index];
     }
 
@@ -55,11 +246,72 @@ public:
         return const_cast<RawMemory&>(*this)[index];
     }
 
+    // allocators are swapped only if they propagate on swap, otherwise they have to be equal
     void Swap(RawMemory& other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(Alloc(), other.Alloc());
+        }
+        else {
+            assert(HasEqualAllocator(other));
+        }
         std::swap(buffer_, other.buffer_);
         std::swap(capacity_, other.capacity_);
     }
 
+    // changes the capacity keeping the bytes of the buffer, the allocator has to support reallocate;
+    // the buffer stays untouched if an exception is thrown
+    void Reallocate(size_t new_capacity) {
+        static_assert(HasReallocate<Allocator>::value, "the allocator can't reallocate");
+        static_assert(IsTriviallyRelocatableV<T>, "items can't be moved by reallocation");
+        if (buffer_ == nullptr) {
+            buffer_ = Allocate(new_capacity);
+        }
+        else {
+            buffer_ = Alloc().reallocate(buffer_, capacity_, new_capacity);
+            if constexpr (VECTOR_STATS_ENABLED) {
+                CountAllocation(new_capacity);
+            }
+        }
+        capacity_ = new_capacity;
+    }
+
+    // frees the buffer and starts using another allocator
+    void ResetAllocator(const Allocator& alloc) noexcept {
+        Deallocate(buffer_, capacity_);
+        buffer_ = nullptr;
+        capacity_ = 0;
+        Alloc() = alloc;
+    }
+
+    // frees the buffer and takes over a buffer of capacity items that the allocator of *this can free
+    void Adopt(T* buffer, size_t capacity) noexcept {
+        assert(buffer != nullptr || capacity == 0);
+        Deallocate(buffer_, capacity_);
+        buffer_ = buffer;
+        capacity_ = capacity;
+    }
+
+    // gives up the buffer without freeing it, it has to be freed with the allocator and the capacity
+    T* Release() noexcept {
+        capacity_ = 0;
+        return std::exchange(buffer_, nullptr);
+    }
+
+    // true if memory allocated by other can be freed by the allocator of *this
+    bool HasEqualAllocator(const RawMemory& other) const noexcept {
+        if constexpr (AllocTraits::is_always_equal::value) {
+            return true;
+        }
+        else {
+            return GetAllocator() == other.GetAllocator();
+        }
+    }
+
+    const Allocator& GetAllocator() const noexcept {
+        return *this;
+    }
+
     T* GetAddress() noexcept {
         return buffer_;
     }
@@ -72,33 +324,209 @@ public:
         return capacity_;
     }
 
+    constexpr bool IsInline() const noexcept {
+        return false;
+    }
+
 private:
-    // allocates raw memory for n items and returns the pointer
-    static T* Allocate(size_t n) {
-        return n != 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;
+    Allocator& Alloc() noexcept {
+        return *this;
+    }
+
+    // allocates raw memory for at least n items and returns the pointer,
+    // n is updated if the allocator gives room for more items
+    T* Allocate(size_t& n) {
+        if (n == 0) {
+            return nullptr;
+        }
+        T* buf = nullptr;
+        if constexpr (HasAllocateAtLeast<Allocator>::value) {
+            const auto result = Alloc().allocate_at_least(n);
+            buf = result.ptr;
+            n = result.count;
+        }
+        else {
+            buf = AllocTraits::allocate(Alloc(), n);
+        }
+        if constexpr (VECTOR_STATS_ENABLED) {
+            CountAllocation(n);
+        }
+        return buf;
     }
 
-    // frees the raw memory that was allocated using Allocate
-    static void Deallocate(T* buf) noexcept {
-        operator delete(buf);
+    static void CountAllocation(size_t n) noexcept {
+        VectorStats& stats = vector_detail::LocalStats();
+        ++stats.allocations;
+        stats.bytes_allocated += n * sizeof(T);
+        stats.peak_capacity_bytes = std::max(stats.peak_capacity_bytes, n * sizeof(T));
+    }
+
+    // frees the raw memory of n items that was allocated using Allocate
+    void Deallocate(T* buf, size_t n) noexcept {
+        if (buf != nullptr) {
+            AllocTraits::deallocate(Alloc(), buf, n);
+        }
     }
 
     T* buffer_ = nullptr;
     size_t capacity_ = 0;
 };
 
-template <typename T>
-class Vector {
+// Growth policies tell the new capacity when a full vector needs room for required items;
+// they only do arithmetic, all allocations and exception safety stay in Vector
+
+// doubles the capacity
+struct DoublingGrowth {
+    static size_t NewCapacity(size_t capacity, size_t required, size_t item_size) noexcept {
+        const size_t max_capacity = std::numeric_limits<size_t>::max() / item_size;
+        const size_t doubled = capacity > max_capacity / 2 ? max_capacity : capacity * 2;
+        return std::max(doubled, required);
+    }
+};
+
+// multiplies the capacity by NUMERATOR / DENOMINATOR, which should be greater than 1
+template <size_t NUMERATOR, size_t DENOMINATOR>
+struct ScaledGrowth {
+    static_assert(NUMERATOR > DENOMINATOR && DENOMINATOR != 0);
+
+    static size_t NewCapacity(size_t capacity, size_t required, size_t item_size) noexcept {
+        const size_t max_capacity = std::numeric_limits<size_t>::max() / item_size;
+        const size_t max_scalable = max_capacity / NUMERATOR * DENOMINATOR;
+        const size_t scaled = capacity > max_scalable
+            ? max_capacity
+            : capacity / DENOMINATOR * NUMERATOR + capacity % DENOMINATOR * NUMERATOR / DENOMINATOR;
+        return std::max({ scaled, capacity + 1, required });
+    }
+};
+
+// lets the allocator reuse freed blocks of previous generations
+using OneAndHalfGrowth = ScaledGrowth<3, 2>;
+using GoldenRatioGrowth = ScaledGrowth<1618, 1000>;
+
+// rounds buffers of at least one page up to a whole number of pages
+template <typename BasePolicy = DoublingGrowth, size_t PAGE_SIZE = 4096>
+struct PageRoundedGrowth {
+    static size_t NewCapacity(size_t capacity, size_t required, size_t item_size) noexcept {
+        const size_t new_capacity = BasePolicy::NewCapacity(capacity, required, item_size);
+        if (new_capacity > (std::numeric_limits<size_t>::max() - PAGE_SIZE) / item_size) {
+            return new_capacity;
+        }
+        const size_t bytes = new_capacity * item_size;
+        return bytes < PAGE_SIZE ? new_capacity : (bytes + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE / item_size;
+    }
+};
+
+// rounds a request up to the number of bytes malloc actually reserves for it
+inline size_t MallocGoodSize(size_t bytes) noexcept {
+#if defined(VECTOR_USE_JEMALLOC)
+    return bytes != 0 ? nallocx(bytes, 0) : 0;
+#elif defined(__APPLE__)
+    return malloc_good_size(bytes);
+#elif defined(__GLIBC__)
+    // ptmalloc chunks carry one size_t of header and are aligned to 2 * sizeof(size_t);
+    // mmap'ed chunks are rounded up to pages, so they have at least as much slack
+    const size_t header = sizeof(size_t);
+    const size_t alignment = 2 * sizeof(size_t);
+    if (bytes > std::numeric_limits<size_t>::max() - header - alignment) {
+        return bytes;
+    }
+    return std::max((bytes + header + alignment - 1) / alignment * alignment, 4 * header) - header;
+#else
+    return bytes;
+#endif
+}
+
+// uses the slack that malloc leaves at the end of blocks anyway
+template <typename BasePolicy = DoublingGrowth>
+struct SizeClassGrowth {
+    static size_t NewCapacity(size_t capacity, size_t required, size_t item_size) noexcept {
+        const size_t new_capacity = BasePolicy::NewCapacity(capacity, required, item_size);
+        if (new_capacity > std::numeric_limits<size_t>::max() / item_size) {
+            return new_capacity;
+        }
+        return std::max(new_capacity, MallocGoodSize(new_capacity * item_size) / item_size);
+    }
+};
+
+// grows like BasePolicy, but never adds more than MAX_STEP_BYTES at once
+template <typename BasePolicy = DoublingGrowth, size_t MAX_STEP_BYTES = 64 * 1024 * 1024>
+struct CappedGrowth {
+    static size_t NewCapacity(size_t capacity, size_t required, size_t item_size) noexcept {
+        const size_t max_step = std::max<size_t>(MAX_STEP_BYTES / item_size, 1);
+        const size_t new_capacity = BasePolicy::NewCapacity(capacity, required, item_size);
+        if (new_capacity - capacity <= max_step) {
+            return new_capacity;
+        }
+        return std::max(capacity + max_step, required);
+    }
+};
+
+// shrinks a vector to twice its size once it is less than 1 / DIVISOR full, the gap between
+// the growth and the shrink thresholds keeps the cost of PushBack/PopBack sequences amortized O(1)
+template <typename BasePolicy = DoublingGrowth, size_t DIVISOR = 4>
+struct AutoShrinkGrowth : BasePolicy {
+    static_assert(DIVISOR > 2, "a shrunk vector must not be full");
+
+    static size_t ShrinkCapacity(size_t size, size_t capacity, size_t /*item_size*/) noexcept {
+        return size < capacity / DIVISOR ? size * 2 : capacity;
+    }
+};
+
+// true if the growth policy has size_t ShrinkCapacity(size_t size, size_t capacity, size_t item_size)
+template <typename GrowthPolicy, typename = void>
+struct HasShrinkCapacity : std::false_type {
+};
+
+template <typename GrowthPolicy>
+struct HasShrinkCapacity<GrowthPolicy, std::void_t<decltype(GrowthPolicy::ShrinkCapacity(size_t{}, size_t{}, size_t{}))>>
+    : std::true_type {
+};
+
+// true if Iterator is an iterator of Category or of a category derived from it
+template <typename Iterator, typename Category, typename = void>
+struct IsIteratorOf : std::false_type {
+};
+
+template <typename Iterator, typename Category>
+struct IsIteratorOf<Iterator, Category, std::void_t<typename std::iterator_traits<Iterator>::iterator_category>>
+    : std::is_base_of<Category, typename std::iterator_traits<Iterator>::iterator_category> {
+};
+
+// selects default-initialization of new items, which leaves items of trivial types uninitialized
+struct DefaultInitTag {
+};
+
+inline constexpr DefaultInitTag DEFAULT_INIT{};
+
+// Storage is RawMemory or a type with the same interface that may keep the first items inline,
+// see InlineRawMemory; new heap buffers are always created as RawMemory and swapped into Storage
+template <typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth,
+          typename Storage = RawMemory<T, Allocator>>
+class Vector : private vector_detail::HardeningState<> {
+    using AllocTraits = std::allocator_traits<Allocator>;
+    using HeapMemory = RawMemory<T, Allocator>;
+
+    // inline items can't be handed over with the buffer and have to be relocated
+    static constexpr bool HAS_INLINE_BUFFER = Storage::INLINE_CAPACITY != 0;
+
 public:
-    using iterator = T*;
-    using const_iterator = const T*;
+    using allocator_type = Allocator;
+    // plain pointers unless the checked mode is on, see vector_hardening.h
+    using iterator = std::conditional_t<VECTOR_HARDENED_ENABLED, vector_detail::CheckedIterator<T, Vector>, T*>;
+    using const_iterator = std::conditional_t<VECTOR_HARDENED_ENABLED, vector_detail::CheckedIterator<const T, Vector>,
+                                              const T*>;
 
     iterator begin() noexcept {
-        return data_.GetAddress();
+        if constexpr (VECTOR_HARDENED_ENABLED) {
+            return iterator(data_.GetAddress(), this);
+        }
+        else {
+            return data_.GetAddress();
+        }
     }
 
     iterator end() noexcept {
-        return data_ + size_;
+        return begin() + size_;
     }
 
     const_iterator begin() const noexcept {
@@ -119,29 +547,106 @@ public:
 
     Vector() = default;
 
-    Vector(size_t size)
-        : data_(size)
+    explicit Vector(const Allocator& alloc) noexcept
+        : data_(alloc) {
+    }
+
+    Vector(size_t size, const Allocator& alloc = Allocator())
+        : data_(size, alloc)
+        , size_(size) {
+        [[maybe_unused]] HardeningScope scope(*this, true);
+        ConstructItems(begin(), size, [to = begin()](size_t first, size_t number) {
+            std::uninitialized_value_construct_n(to + first, number);
+        });
+    }
+
+    Vector(size_t size, DefaultInitTag, const Allocator& alloc = Allocator())
+        : data_(size, alloc)
         , size_(size) {
-        std::uninitialized_value_construct_n(begin(), size);
+        [[maybe_unused]] HardeningScope scope(*this, true);
+        if constexpr (!std::is_trivially_default_constructible_v<T>) {
+            ConstructItems(begin(), size, [to = begin()](size_t first, size_t number) {
+                std::uninitialized_default_construct_n(to + first, number);
+            });
+        }
+    }
+
+    template <typename InputIt, typename = std::enable_if_t<IsIteratorOf<InputIt, std::input_iterator_tag>::value>>
+    Vector(InputIt first, InputIt last, const Allocator& alloc = Allocator(),
+           vector_detail::TraceSite site = vector_detail::TraceSite::Current())
+        : Vector(alloc) {
+        Append(first, last, site);
+    }
+
+    Vector(std::initializer_list<T> items, const Allocator& alloc = Allocator(),
+           vector_detail::TraceSite site = vector_detail::TraceSite::Current())
+        : Vector(items.begin(), items.end(), alloc, site) {
     }
 
     Vector(const Vector& other)
-        : data_(other.size_)
-        , size_(other.size_) {
-        std::uninitialized_copy_n(other.data_.GetAddress(), size_, begin());
+        : Vector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {
     }
 
-    Vector(Vector&& other) noexcept
-        : data_(std::move(other.data_))
+    Vector(const Vector& other, const Allocator& alloc)
+        : data_(other.size_, alloc)
         , size_(other.size_) {
-        other.size_ = 0;
+        [[maybe_unused]] HardeningScope scope(*this, true);
+        ConstructItems(begin(), size_, [from = other.begin(), to = begin()](size_t first, size_t number) {
+            std::uninitialized_copy_n(from + first, number, to + first);
+        });
+    }
+
+    Vector(Vector&& other) noexcept(!HAS_INLINE_BUFFER || std::is_nothrow_move_constructible_v<T>)
+        : data_(std::move(other.data_)) {
+        [[maybe_unused]] HardeningScope scope(*this, true);
+        [[maybe_unused]] HardeningScope other_scope(other);
+        if constexpr (HAS_INLINE_BUFFER) {
+            if (data_.IsInline()) {
+                RelocateToNewBuffer(other.begin(), begin(), other.size_);
+            }
+        }
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    // steals the buffer if alloc can free it, otherwise moves the elements one by one
+    Vector(Vector&& other, const Allocator& alloc)
+        : data_(alloc) {
+        [[maybe_unused]] HardeningScope scope(*this, true);
+        [[maybe_unused]] HardeningScope other_scope(other);
+        if (data_.HasEqualAllocator(other.data_) && !other.data_.IsInline()) {
+            data_.Swap(other.data_);
+            size_ = std::exchange(other.size_, 0);
+        }
+        else {
+            Reserve(other.size_, vector_detail::TraceSite{});
+            std::uninitialized_move_n(other.begin(), other.size_, begin());
+            size_ = other.size_;
+        }
     }
 
     Vector& operator=(const Vector& rhs) {
+        [[maybe_unused]] HardeningScope scope(*this);
         if (this != &rhs) {
-            if (rhs.size_ > data_.Capacity()) { //copy and swap
-                Vector rhs_copy(rhs);
-                Swap(rhs_copy);
+            if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+                if (!data_.HasEqualAllocator(rhs.data_)) {
+                    // the current buffer can be freed only by the current allocator
+                    std::destroy_n(begin(), size_);
+                    size_ = 0;
+                    data_.ResetAllocator(rhs.GetAllocator());
+                }
+            }
+
+            if (rhs.size_ > data_.Capacity()) {
+                // the new capacity comes from the growth policy, so assigning a vector that keeps
+                // growing a little reallocates O(log n) times instead of every time
+                HeapMemory new_data(GrowthPolicy::NewCapacity(data_.Capacity(), rhs.size_, sizeof(T)), GetAllocator());
+                ConstructItems(new_data.GetAddress(), rhs.size_,
+                               [from = rhs.data_.GetAddress(), to = new_data.GetAddress()](size_t first, size_t number) {
+                                   std::uninitialized_copy_n(from + first, number, to + first);
+                               });
+                DestroyItems(data_.GetAddress(), size_);
+                data_.Swap(new_data);
+                size_ = rhs.size_;
             }
             else {
                 std::copy_n(rhs.begin(), std::min(size_, rhs.size_), begin());
@@ -159,21 +664,66 @@ public:
         return *this;
     }
 
-    Vector& operator=(Vector&& rhs) noexcept {
-        data_ = std::move(rhs.data_);
-        size_ = std::exchange(rhs.size_, 0);
+    Vector& operator=(Vector&& rhs) noexcept((AllocTraits::propagate_on_container_move_assignment::value
+                                              || AllocTraits::is_always_equal::value)
+                                             && (!HAS_INLINE_BUFFER || std::is_nothrow_move_constructible_v<T>)) {
+        if (this == &rhs) {
+            return *this;
+        }
+        [[maybe_unused]] HardeningScope scope(*this);
+        [[maybe_unused]] HardeningScope rhs_scope(rhs);
+
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value || AllocTraits::is_always_equal::value) {
+            StealBuffer(rhs);
+        }
+        else if (data_.HasEqualAllocator(rhs.data_)) {
+            StealBuffer(rhs);
+        }
+        else if (rhs.size_ > data_.Capacity()) { // buffer of rhs can't be stolen, move elements one by one
+            Vector rhs_moved(std::move(rhs), GetAllocator());
+            Swap(rhs_moved);
+        }
+        else {
+            std::move(rhs.begin(), rhs.begin() + std::min(size_, rhs.size_), begin());
+
+            if (rhs.size_ < size_) {
+                std::destroy_n(begin() + rhs.size_, size_ - rhs.size_);
+            }
+            else {
+                std::uninitialized_move_n(rhs.begin() + size_, rhs.size_ - size_, end());
+            }
+
+            size_ = rhs.size_;
+        }
         return *this;
     }
 
     ~Vector() noexcept {
-        std::destroy_n(begin(), size_);
+        if constexpr (VECTOR_HARDENED_ENABLED) {
+            AnnotateItems(data_.Capacity());
+        }
+        DestroyItems(begin(), size_);
     }
 
-    void Swap(Vector& other) noexcept {
+    void Swap(Vector& other) noexcept(!HAS_INLINE_BUFFER || std::is_nothrow_move_constructible_v<T>) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        [[maybe_unused]] HardeningScope other_scope(other);
+        if constexpr (HAS_INLINE_BUFFER) {
+            if (data_.IsInline() || other.data_.IsInline()) {
+                Vector temp(std::move(other));
+                other = std::move(*this);
+                *this = std::move(temp);
+                return;
+            }
+        }
         std::swap(size_, other.size_);
         data_.Swap(other.data_);
     }
 
+    Allocator GetAllocator() const noexcept {
+        return data_.GetAllocator();
+    }
+
     size_t Size() const noexcept {
         return size_;
     }
@@ -184,6 +734,7 @@ public:
 
     T& operator[](size_t index) noexcept {
         assert(index < size_);
+        vector_detail::HardeningCheck(index < size_, "Vector index is out of range");
         return data_[index];
     }
 
@@ -191,46 +742,157 @@ public:
         return const_cast<Vector&>(*this)[index];
     }
 
-    void Reserve(size_t capacity) {
+    // the items as a plain array, also in the checked mode
+    T* Data() noexcept {
+        return data_.GetAddress();
+    }
+
+    const T* Data() const noexcept {
+        return data_.GetAddress();
+    }
+
+    void Reserve(size_t capacity, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
         if (capacity <= data_.Capacity()) {
             return;
         }
+        ChangeCapacity(capacity, site);
+    }
 
-        RawMemory<T> new_data(capacity);
-        CopyOrMoveToNewBuffer(begin(), new_data.GetAddress(), size_);
-        std::destroy_n(begin(), size_);
-        data_.Swap(new_data);
+    // takes ownership of a buffer of capacity items with size constructed items in front,
+    // which alloc has to be able to free, e.g. a buffer given up by Release
+    static Vector Adopt(T* ptr, size_t size, size_t capacity, const Allocator& alloc = Allocator()) noexcept {
+        assert(size <= capacity);
+        Vector vector(alloc);
+        [[maybe_unused]] HardeningScope scope(vector);
+        if (capacity != 0) {
+            HeapMemory adopted(alloc);
+            adopted.Adopt(ptr, capacity);
+            vector.data_.Swap(adopted);
+            vector.size_ = size;
+        }
+        return vector;
     }
 
-    void Resize(size_t new_size) {
+    // gives up the buffer and the items without destroying them and leaves the vector empty;
+    // the caller destroys the items and frees the buffer with GetAllocator() and the capacity.
+    // A small vector relocates inline items to the heap first
+    ReleasedBuffer<T> Release() noexcept(!HAS_INLINE_BUFFER) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        if constexpr (HAS_INLINE_BUFFER) {
+            if (data_.IsInline()) {
+                if (size_ == 0) {
+                    return {};
+                }
+                HeapMemory new_data(size_, GetAllocator());
+                RelocateToNewBuffer(begin(), new_data.GetAddress(), size_);
+                data_.Swap(new_data);
+            }
+        }
+        HeapMemory released(GetAllocator());
+        data_.Swap(released);
+        const size_t capacity = released.Capacity();
+        return { released.Release(), std::exchange(size_, 0), capacity };
+    }
+
+    // releases the unused capacity, a small vector returns to its inline buffer if the items fit into it
+    void ShrinkToFit(vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        if (size_ < data_.Capacity()) {
+            ChangeCapacity(size_, site);
+        }
+    }
+
+    // destroys the items keeping the capacity
+    void Clear() noexcept {
+        [[maybe_unused]] HardeningScope scope(*this);
+        DestroyItems(begin(), size_);
+        size_ = 0;
+    }
+
+    // destroys the items and frees the buffer
+    void ClearAndRelease() noexcept {
+        [[maybe_unused]] HardeningScope scope(*this);
+        Clear();
+        HeapMemory empty(GetAllocator());
+        data_.Swap(empty);
+    }
+
+    void Resize(size_t new_size, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
         if (new_size < size_) {
             std::destroy_n(begin() + new_size, size_ - new_size);
+            size_ = new_size;
+            ShrinkIfSparse(site);
         }
         else {
-            Reserve(new_size);
+            Reserve(new_size, site);
             std::uninitialized_value_construct_n(end(), new_size - size_);
+            size_ = new_size;
+        }
+    }
+
+    // like Resize, but new items of trivial types are not zeroed
+    void ResizeDefaultInit(size_t new_size, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        if (new_size < size_) {
+            std::destroy_n(begin() + new_size, size_ - new_size);
+            size_ = new_size;
+            ShrinkIfSparse(site);
+        }
+        else {
+            Reserve(new_size, site);
+            std::uninitialized_default_construct_n(end(), new_size - size_);
+            size_ = new_size;
         }
+    }
+
+    // makes room for count items and lets op(T* data, size_t count) write them,
+    // op returns the new size that must not exceed count; the items are not initialized before the call
+    template <typename Operation>
+    void ResizeAndOverwrite(size_t count, Operation op,
+                            vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+                      "items are overwritten without construction and destruction");
+        Reserve(count, site);
+        if (count > size_) {
+            std::uninitialized_default_construct(data_ + size_, data_ + count);
+        }
+        const size_t new_size = std::move(op)(Data(), count);
+        assert(new_size <= count);
         size_ = new_size;
     }
 
-    void PushBack(const T& value) {
-        [[maybe_unused]] T& res = EmplaceBack(value);
+    void PushBack(const T& value, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] T& res = EmplaceBackAt(site, value);
     }
 
-    void PushBack(T&& value) {
-        [[maybe_unused]] T& res = EmplaceBack(std::move(value));
+    void PushBack(T&& value, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] T& res = EmplaceBackAt(site, std::move(value));
     }
 
     void PopBack() noexcept {
+        [[maybe_unused]] HardeningScope scope(*this);
+        vector_detail::HardeningCheck(size_ != 0, "PopBack of an empty Vector");
         data_[size_ - 1].~T();
         --size_;
+        ShrinkIfSparse(vector_detail::TraceSite{});
     }
 
     template <typename... Args>
     [[nodiscard]] T& EmplaceBack(Args&&... args) {
+        return EmplaceBackAt(vector_detail::TraceSite{}, std::forward<Args>(args)...);
+    }
+
+    // EmplaceBack that traces a growth with site, e.g. EmplaceBackAt(VectorCallSite::Current(), args...),
+    // as a defaulted site can't follow the arguments
+    template <typename... Args>
+    [[nodiscard]] T& EmplaceBackAt(const vector_detail::TraceSite& site, Args&&... args) {
+        [[maybe_unused]] HardeningScope scope(*this);
 
         if (size_ == data_.Capacity()) {
-            return *ReallocateMemoryAddingNewElement(size_, std::forward<Args>(args)...);
+            return *ReallocateMemoryAddingNewElement(site, size_, std::forward<Args>(args)...);
         }
 
         T* ptr = new (data_ + size_) T(std::forward<Args>(args)...);
@@ -238,82 +900,709 @@ public:
         return *ptr;
     }
 
-    [[nodiscard]] iterator Insert(const_iterator pos, const T& value) {
-        return Emplace(pos, value);
+    [[nodiscard]] iterator Insert(const_iterator pos, const T& value,
+                                  vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        return EmplaceAt(site, pos, value);
+    }
+
+    [[nodiscard]] iterator Insert(const_iterator pos, T&& value,
+                                  vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        return EmplaceAt(site, pos, std::move(value));
+    }
+
+    // inserts count copies of value reallocating at most once
+    [[nodiscard]] iterator Insert(const_iterator pos, size_t count, const T& value,
+                                  vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        if (IsInside(std::addressof(value))) {
+            const T value_copy(value);
+            return Insert(pos, count, value_copy, site);
+        }
+        return InsertWith(pos - cbegin(), count, [&value, count](T* to) {
+            std::uninitialized_fill_n(to, count, value);
+        }, site);
+    }
+
+    // inserts copies of [first, last), which must not refer to the items of the vector;
+    // forward iterators give a single reallocation and a single shift of the tail
+    template <typename InputIt, typename = std::enable_if_t<IsIteratorOf<InputIt, std::input_iterator_tag>::value>>
+    [[nodiscard]] iterator Insert(const_iterator pos, InputIt first, InputIt last,
+                                  vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        const size_t index = pos - cbegin();
+        if constexpr (IsIteratorOf<InputIt, std::forward_iterator_tag>::value) {
+            const size_t count = static_cast<size_t>(std::distance(first, last));
+            return InsertWith(index, count, [first, count](T* to) {
+                std::uninitialized_copy_n(first, count, to);
+            }, site);
+        }
+        else {
+            const size_t old_size = size_;
+            for (; first != last; ++first) {
+                [[maybe_unused]] T& res = EmplaceBackAt(site, *first);
+            }
+            std::rotate(begin() + index, begin() + old_size, end());
+            return begin() + index;
+        }
+    }
+
+    [[nodiscard]] iterator Insert(const_iterator pos, std::initializer_list<T> items,
+                                  vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        return Insert(pos, items.begin(), items.end(), site);
+    }
+
+    template <typename InputIt, typename = std::enable_if_t<IsIteratorOf<InputIt, std::input_iterator_tag>::value>>
+    void Append(InputIt first, InputIt last, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] iterator res = Insert(cend(), first, last, site);
+    }
+
+    void Append(std::initializer_list<T> items, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        Append(items.begin(), items.end(), site);
+    }
+
+    // moves the items of other to the end leaving other empty: an empty vector takes the buffer of other
+    // if it can free it and has no bigger one, otherwise the items are relocated in bulk to a buffer
+    // growing by the policy. If an exception is thrown both vectors stay untouched
+    void AppendMove(Vector&& other, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        assert(&other != this);
+        [[maybe_unused]] HardeningScope scope(*this);
+        [[maybe_unused]] HardeningScope other_scope(other);
+        if (size_ == 0 && data_.Capacity() <= other.data_.Capacity() && data_.HasEqualAllocator(other.data_)) {
+            StealBuffer(other);
+            return;
+        }
+        if (size_ + other.size_ > data_.Capacity()) {
+            ChangeCapacity(GrowthPolicy::NewCapacity(data_.Capacity(), size_ + other.size_, sizeof(T)), site);
+        }
+        RelocateToNewBuffer(other.data_.GetAddress(), data_ + size_, other.size_);
+        size_ += std::exchange(other.size_, 0);
+    }
+
+    // moves the items of other before pos leaving other empty, with one shift of the tail. If an exception
+    // is thrown other keeps its items and the vector changes only as InsertWith allows: items that throw
+    // on move may be left moved-from. Such items, if they can be copied, are copied out of other into
+    // a buffer grown beforehand and leave other only when all of them are in place
+    [[nodiscard]] iterator Splice(const_iterator pos, Vector&& other,
+                                  vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        assert(&other != this);
+        [[maybe_unused]] HardeningScope scope(*this);
+        [[maybe_unused]] HardeningScope other_scope(other);
+        const size_t index = pos - cbegin();
+        if (index == size_) {
+            AppendMove(std::move(other), site);
+            return begin() + index;
+        }
+        if constexpr (IsTriviallyRelocatableV<T>
+                      || (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>)) {
+            // nothing throws once the items left other
+            return InsertWith(index, other.size_, [&other](T* to) {
+                RelocateToNewBuffer(other.data_.GetAddress(), to, other.size_);
+                other.size_ = 0;
+            }, site);
+        }
+        else {
+            if (size_ + other.size_ > data_.Capacity()) {
+                ChangeCapacity(GrowthPolicy::NewCapacity(data_.Capacity(), size_ + other.size_, sizeof(T)), site);
+            }
+            const iterator inserted = InsertWith(index, other.size_, [&other](T* to) {
+                CopyOrMoveToNewBuffer(other.data_.GetAddress(), to, other.size_);
+            }, site);
+            DestroyItems(other.data_.GetAddress(), std::exchange(other.size_, 0));
+            return inserted;
+        }
+    }
+
+    // replaces the items with copies of [first, last), which must not refer to the items of the vector
+    template <typename InputIt, typename = std::enable_if_t<IsIteratorOf<InputIt, std::input_iterator_tag>::value>>
+    void Assign(InputIt first, InputIt last, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        if constexpr (IsIteratorOf<InputIt, std::forward_iterator_tag>::value) {
+            const size_t count = static_cast<size_t>(std::distance(first, last));
+            if (count > data_.Capacity()) {
+                Vector items(first, last, GetAllocator(), site);
+                Swap(items);
+                return;
+            }
+
+            const size_t num_assigned = std::min(size_, count);
+            InputIt mid = std::next(first, num_assigned);
+            std::copy(first, mid, begin());
+            if (count < size_) {
+                std::destroy_n(begin() + count, size_ - count);
+            }
+            else {
+                std::uninitialized_copy(mid, last, end());
+            }
+            size_ = count;
+        }
+        else {
+            std::destroy_n(begin(), size_);
+            size_ = 0;
+            Append(first, last, site);
+        }
+    }
+
+    void Assign(size_t count, const T& value, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        if (count > data_.Capacity()) {
+            Vector items(GetAllocator());
+            [[maybe_unused]] iterator inserted = items.Insert(items.cend(), count, value, site);
+            Swap(items);
+            return;
+        }
+
+        std::fill_n(begin(), std::min(size_, count), value);
+        if (count < size_) {
+            std::destroy_n(begin() + count, size_ - count);
+        }
+        else {
+            std::uninitialized_fill_n(end(), count - size_, value);
+        }
+        size_ = count;
     }
 
-    [[nodiscard]] iterator Insert(const_iterator pos, T&& value) {
-        return Emplace(pos, std::move(value));
+    void Assign(std::initializer_list<T> items, vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        Assign(items.begin(), items.end(), site);
     }
 
+    // args may refer to the items. If they don't, the item is built straight in the gap when the items
+    // are trivially relocatable or their moves don't throw, and the tail is moved back if the constructor
+    // throws; other items are built there only by a nothrow constructor, otherwise aside and moved in
     template <typename... Args>
     [[nodiscard]] iterator Emplace(const_iterator pos, Args&&... args) {
+        return EmplaceAt(vector_detail::TraceSite{}, pos, std::forward<Args>(args)...);
+    }
+
+    // Emplace that traces a growth with site, see EmplaceBackAt
+    template <typename... Args>
+    [[nodiscard]] iterator EmplaceAt(const vector_detail::TraceSite& site, const_iterator pos, Args&&... args) {
+        [[maybe_unused]] HardeningScope scope(*this);
         size_t index = pos - begin();
+        vector_detail::HardeningCheck(index <= size_, "Emplace position is out of range");
 
         if (index == size_) {
-            return &EmplaceBack(std::forward<Args>(args)...);
+            [[maybe_unused]] T& item = EmplaceBackAt(site, std::forward<Args>(args)...);
+            return begin() + index;
         }
 
         if (size_ == data_.Capacity()) {
-            return ReallocateMemoryAddingNewElement(index, std::forward<Args>(args)...);
+            ReallocateMemoryAddingNewElement(site, index, std::forward<Args>(args)...);
+            return begin() + index;
+        }
+
+        if constexpr (IsTriviallyRelocatableV<T>
+                      || (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>)) {
+            if (!RefersToItems(args...)) {
+                // built straight in the gap, the tail is moved back if the constructor throws
+                return InsertWith(index, 1, [&args...](T* to) {
+                    new (to) T(std::forward<Args>(args)...);
+                }, site);
+            }
         }
 
-        T temp_value(std::forward<Args>(args)...);
-        new (end()) T(std::move(data_[size_ - 1]));
-        std::move_backward(begin() + index, end() - 1, end());
-        data_[index] = std::move(temp_value);
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            // the value is built aside as args refer to an element, then relocated into the gap
+            alignas(T) unsigned char temp_value[sizeof(T)];
+            T* temp_ptr = new (temp_value) T(std::forward<Args>(args)...);
+            std::memmove(static_cast<void*>(begin() + index + 1), begin() + index, (size_ - index) * sizeof(T));
+            std::memcpy(static_cast<void*>(begin() + index), temp_ptr, sizeof(T));
+        }
+        else {
+            if constexpr (!std::is_nothrow_move_constructible_v<T> || !std::is_nothrow_move_assignable_v<T>) {
+                if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+                    if (!RefersToItems(args...)) {
+                        // the moved-from item in the gap is replaced, which saves moving a temporary value
+                        new (end()) T(std::move(data_[size_ - 1]));
+                        std::move_backward(begin() + index, end() - 1, end());
+                        std::destroy_at(data_ + index);
+                        new (begin() + index) T(std::forward<Args>(args)...);
+                        ++size_;
+                        return begin() + index;
+                    }
+                }
+            }
+            T temp_value(std::forward<Args>(args)...);
+            new (end()) T(std::move(data_[size_ - 1]));
+            std::move_backward(begin() + index, end() - 1, end());
+            data_[index] = std::move(temp_value);
+        }
         ++size_;
         return begin() + index;
     }
 
-    [[nodiscard]] iterator Erase(const_iterator pos) noexcept(std::is_nothrow_move_assignable_v<T>) {
+    // inserts count items built from factory(i) for i from 0 to count - 1 opening the gap with a single
+    // shift of the tail; the results of factory must not refer to the items of the vector. The items are
+    // built straight in the gap if they are trivially relocatable or their moves don't throw, the tail
+    // is moved back if factory or a constructor throws; other items are built aside and then moved in
+    template <typename Factory>
+    iterator EmplaceMany(const_iterator pos, size_t count, Factory factory,
+                         vector_detail::TraceSite site = vector_detail::TraceSite::Current()) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        return InsertWith(pos - cbegin(), count, [count, &factory](T* to) {
+            size_t built = 0;
+            try {
+                for (; built < count; ++built) {
+                    new (to + built) T(factory(built));
+                }
+            }
+            catch (...) {
+                std::destroy_n(to, built);
+                throw;
+            }
+        }, site);
+    }
+
+    [[nodiscard]] iterator Erase(const_iterator pos) noexcept(IsTriviallyRelocatableV<T>
+                                                              || std::is_nothrow_move_assignable_v<T>) {
+        [[maybe_unused]] HardeningScope scope(*this);
         size_t index = pos - begin();
-        std::move(begin() + index + 1, end(), begin() + index);
-        data_[size_ - 1].~T();
+        vector_detail::HardeningCheck(index < size_, "Erase position is out of range");
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            data_[index].~T();
+            std::memmove(static_cast<void*>(begin() + index), begin() + index + 1, (size_ - index - 1) * sizeof(T));
+        }
+        else {
+            std::move(begin() + index + 1, end(), begin() + index);
+            data_[size_ - 1].~T();
+        }
         --size_;
+        ShrinkIfSparse(vector_detail::TraceSite{});
         return begin() + index;
     }
 
+    // removes the items of [first, last) shifting the tail once
+    iterator Erase(const_iterator first, const_iterator last) noexcept(IsTriviallyRelocatableV<T>
+                                                                       || std::is_nothrow_move_assignable_v<T>) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        const size_t index = first - cbegin();
+        const size_t count = last - first;
+        vector_detail::HardeningCheck(index <= size_ && count <= size_ - index, "Erase range is out of range");
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            std::destroy_n(begin() + index, count);
+            std::memmove(static_cast<void*>(begin() + index), begin() + index + count,
+                         (size_ - index - count) * sizeof(T));
+        }
+        else {
+            std::move(begin() + index + count, end(), begin() + index);
+            std::destroy_n(end() - count, count);
+        }
+        size_ -= count;
+        ShrinkIfSparse(vector_detail::TraceSite{});
+        return begin() + index;
+    }
+
+    // removes the items satisfying pred keeping the order of the rest in a single pass,
+    // returns the number of removed items
+    template <typename Predicate>
+    size_t EraseIf(Predicate pred) {
+        [[maybe_unused]] HardeningScope scope(*this);
+        const size_t old_size = size_;
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            size_t kept = 0;
+            size_t index = 0;
+            try {
+                for (; index < size_; ++index) {
+                    if (pred(data_[index])) {
+                        data_[index].~T();
+                    }
+                    else {
+                        if (kept != index) {
+                            std::memcpy(static_cast<void*>(begin() + kept), begin() + index, sizeof(T));
+                        }
+                        ++kept;
+                    }
+                }
+            }
+            catch (...) {
+                // the unchecked items close the gap
+                std::memmove(static_cast<void*>(begin() + kept), begin() + index, (size_ - index) * sizeof(T));
+                size_ = kept + size_ - index;
+                throw;
+            }
+            size_ = kept;
+        }
+        else {
+            iterator new_end = std::remove_if(begin(), end(), pred);
+            std::destroy(new_end, end());
+            size_ = new_end - begin();
+        }
+        ShrinkIfSparse(vector_detail::TraceSite{});
+        return old_size - size_;
+    }
+
 private:
-    RawMemory<T> data_;
+    // the buffer is resized by the allocator instead of being copied
+    static constexpr bool GROWS_IN_PLACE = IsTriviallyRelocatableV<T> && HasReallocate<Allocator>::value;
+
+    Storage data_;
     size_t size_ = 0;
 
-    static void CopyOrMoveToNewBuffer(T* from, T* to, size_t number) {
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move_n(from, number, to);
+    template <typename, typename>
+    friend class vector_detail::CheckedIterator;
+
+    // the generation of the checked mode, it is bumped when the buffer or the capacity turns out to be new
+    size_t Generation() const noexcept {
+        if constexpr (VECTOR_HARDENED_ENABLED) {
+            if (this->seen_buffer != data_.GetAddress() || this->seen_capacity != data_.Capacity()) {
+                this->seen_buffer = data_.GetAddress();
+                this->seen_capacity = data_.Capacity();
+                ++this->generation;
+            }
+            return this->generation;
         }
         else {
-            std::uninitialized_copy_n(from, number, to);
+            return 0;
         }
     }
 
-    size_t CalcNewCapacity() const noexcept {
-        return size_ == 0 ? 1 : size_ * 2;
+    bool IsInCapacity(const void* ptr) const noexcept {
+        const auto* bytes = static_cast<const unsigned char*>(ptr);
+        const auto* items = reinterpret_cast<const unsigned char*>(data_.GetAddress());
+        return std::greater_equal<>{}(bytes, items) && std::less<>{}(bytes, items + data_.Capacity() * sizeof(T));
     }
 
-    template <typename... Args>
-    T* ReallocateMemoryAddingNewElement(size_t index, Args&&... args) {
-        RawMemory<T> new_data(CalcNewCapacity());
-        T* ptr = new (new_data + index) T(std::forward<Args>(args)...);
-        try {
-            CopyOrMoveToNewBuffer(begin(), new_data.GetAddress(), index);
-            std::destroy_n(begin(), index);
+    // in the checked mode opens the whole buffer to the sanitizer for a public operation that changes
+    // the vector and closes the unused capacity when the outermost one ends; a constructor that throws
+    // leaves the buffer open as it is going to be freed
+    class HardeningScope {
+    public:
+        explicit HardeningScope(Vector& vector, bool constructs = false) noexcept
+            : vector_(vector) {
+            if constexpr (VECTOR_HARDENED_ENABLED) {
+                constructs_ = constructs;
+                exceptions_ = std::uncaught_exceptions();
+                if (vector_.operation_depth++ == 0) {
+                    vector_.AnnotateItems(vector_.data_.Capacity());
+                }
+            }
         }
-        catch (...) {
-            ptr->~T();
-            throw;
+
+        HardeningScope(const HardeningScope&) = delete;
+
+        HardeningScope& operator=(const HardeningScope&) = delete;
+
+        ~HardeningScope() {
+            if constexpr (VECTOR_HARDENED_ENABLED) {
+                if (--vector_.operation_depth == 0) {
+                    const bool is_failed_construction = constructs_ && std::uncaught_exceptions() > exceptions_;
+                    vector_.AnnotateItems(is_failed_construction ? vector_.data_.Capacity() : vector_.size_);
+                    [[maybe_unused]] size_t generation = vector_.Generation();
+                }
+            }
         }
 
-        if (index < size_) {
+    private:
+        Vector& vector_;
+        bool constructs_ = false;
+        int exceptions_ = 0;
+    };
+
+    // the first accessible items of the buffer for the sanitizer
+    void AnnotateItems(size_t accessible) noexcept {
+        const T* items = data_.GetAddress();
+        vector_detail::AnnotateBuffer(items, items + data_.Capacity(), items + accessible);
+    }
+
+    void StealBuffer(Vector& rhs) noexcept(!HAS_INLINE_BUFFER || std::is_nothrow_move_constructible_v<T>) {
+        std::destroy_n(begin(), size_);
+        size_ = 0;
+        data_ = std::move(rhs.data_);
+        if constexpr (HAS_INLINE_BUFFER) {
+            if (data_.IsInline()) {
+                RelocateToNewBuffer(rhs.begin(), begin(), rhs.size_);
+            }
+        }
+        size_ = std::exchange(rhs.size_, 0);
+    }
+
+    // moves number items to uninitialized memory and destroys the sources,
+    // the sources stay untouched if an exception is thrown
+    static void RelocateToNewBuffer(T* from, T* to, size_t number) {
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            ConstructItems(to, number, [from, to](size_t first, size_t count) {
+                if (count != 0) {
+                    std::memcpy(static_cast<void*>(to + first), from + first, count * sizeof(T));
+                }
+            });
+            if constexpr (VECTOR_STATS_ENABLED) {
+                vector_detail::LocalStats().items_relocated += number;
+            }
+        }
+        else {
+            CopyOrMoveToNewBuffer(from, to, number);
+            DestroyItems(from, number);
+        }
+    }
+
+    // moves the items to new_data leaving count items that are already constructed at index in between;
+    // if an exception is thrown these count items are destroyed and the vector stays untouched
+    void RelocateAroundGap(HeapMemory& new_data, size_t index, size_t count) {
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            RelocateToNewBuffer(begin(), new_data.GetAddress(), index);
+            RelocateToNewBuffer(begin() + index, new_data + index + count, size_ - index);
+        }
+        else {
+            try {
+                CopyOrMoveToNewBuffer(begin(), new_data.GetAddress(), index);
+            }
+            catch (...) {
+                std::destroy_n(new_data + index, count);
+                throw;
+            }
+
+            try {
+                CopyOrMoveToNewBuffer(begin() + index, new_data + index + count, size_ - index);
+            }
+            catch (...) {
+                std::destroy_n(new_data.GetAddress(), index + count);
+                throw;
+            }
+            // the old items are destroyed only when all of them are in the new buffer
+            DestroyItems(begin(), size_);
+        }
+    }
+
+    // inserts count items at index, construct(T* to) has to build all of them in uninitialized memory
+    // or none of them and must not read the items, which may be shifted already; the vector stays
+    // untouched if an exception is thrown, with one exception: items that aren't trivially
+    // relocatable and throw on move may be left moved-from
+    template <typename Constructor>
+    iterator InsertWith(size_t index, size_t count, Constructor construct,
+                        const vector_detail::TraceSite& site) {
+        vector_detail::HardeningCheck(index <= size_, "Insert position is out of range");
+        if (count == 0) {
+            return begin() + index;
+        }
+
+        if (size_ + count > data_.Capacity()) {
+            [[maybe_unused]] vector_detail::GrowthTrace<Storage> trace(data_, size_, sizeof(T), site);
+            const size_t new_capacity = GrowthPolicy::NewCapacity(data_.Capacity(), size_ + count, sizeof(T));
+            if constexpr (VECTOR_STATS_ENABLED) {
+                CountReallocation();
+            }
+            bool grown_in_place = false;
+            if constexpr (GROWS_IN_PLACE) {
+                if (!data_.IsInline()) {
+                    data_.Reallocate(new_capacity);
+                    grown_in_place = true;
+                }
+            }
+
+            if (!grown_in_place) {
+                HeapMemory new_data(new_capacity, GetAllocator());
+                construct(new_data + index);
+                RelocateAroundGap(new_data, index, count);
+                data_.Swap(new_data);
+                size_ += count;
+                return begin() + index;
+            }
+        }
+
+        const size_t tail = size_ - index;
+        if constexpr (IsTriviallyRelocatableV<T>) {
+            std::memmove(static_cast<void*>(begin() + index + count), begin() + index, tail * sizeof(T));
+            try {
+                construct(begin() + index);
+            }
+            catch (...) {
+                std::memmove(static_cast<void*>(begin() + index), begin() + index + count, tail * sizeof(T));
+                throw;
+            }
+        }
+        else if constexpr (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>) {
+            // the tail is moved count places on, the moved-from items of the gap are destroyed
+            // and the new items are built there; the tail is moved back if the constructor throws
+            T* const gap = data_ + index;
+            const size_t moved_to_end = std::min(count, tail);
+            std::uninitialized_move(data_ + size_ - moved_to_end, data_ + size_, data_ + size_ + count - moved_to_end);
+            std::move_backward(gap, data_ + size_ - moved_to_end, data_ + size_ + count - moved_to_end);
+            std::destroy_n(gap, moved_to_end);
+            try {
+                construct(gap);
+            }
+            catch (...) {
+                std::uninitialized_move_n(gap + count, moved_to_end, gap);
+                std::move(gap + count + moved_to_end, data_ + size_ + count, gap + moved_to_end);
+                std::destroy_n(data_ + size_ + count - moved_to_end, moved_to_end);
+                throw;
+            }
+        }
+        else {
+            // the items are built aside first, so a throwing construct leaves the items where they are
+            HeapMemory items(count, GetAllocator());
+            construct(items.GetAddress());
+            // the slots past end() built so far are destroyed with the items if a move throws
+            T* built_first = end();
+            T* built_last = end();
             try {
-                CopyOrMoveToNewBuffer(begin() + index, new_data.GetAddress() + index + 1, size_ - index);
-                std::destroy_n(begin() + index, size_ - index);
+                if (tail > count) {
+                    std::uninitialized_move_n(end() - count, count, end());
+                    built_last = end() + count;
+                    std::move_backward(begin() + index, end() - count, end());
+                    std::move(items.GetAddress(), items + count, begin() + index);
+                }
+                else {
+                    std::uninitialized_move(begin() + index, end(), begin() + index + count);
+                    built_first = begin() + index + count;
+                    built_last = end() + count;
+                    std::move(items.GetAddress(), items + tail, begin() + index);
+                    std::uninitialized_move(items + tail, items + count, end());
+                }
             }
             catch (...) {
-                std::destroy_n(new_data.GetAddress(), index + 1);
+                std::destroy(built_first, built_last);
+                std::destroy_n(items.GetAddress(), count);
                 throw;
             }
+            std::destroy_n(items.GetAddress(), count);
         }
+        size_ += count;
+        return begin() + index;
+    }
+
+    // true if ptr points into the memory of the items
+    bool IsInside(const void* ptr) const noexcept {
+        const auto* bytes = static_cast<const unsigned char*>(ptr);
+        const auto* items = reinterpret_cast<const unsigned char*>(data_.GetAddress());
+        return std::greater_equal<>{}(bytes, items) && std::less<>{}(bytes, items + size_ * sizeof(T));
+    }
+
+    // true if one of objects lies in the items, e.g. an argument of Emplace that refers to an item;
+    // pointers to items stored inside the objects are not detected
+    template <typename... Objects>
+    bool RefersToItems(const Objects&... objects) const noexcept {
+        return (IsInside(std::addressof(objects)) || ...);
+    }
+
+    // moves the items to a buffer of new_capacity that is not less than the size;
+    // the vector stays untouched if an exception is thrown
+    void ChangeCapacity(size_t new_capacity, const vector_detail::TraceSite& site) {
+        assert(new_capacity >= size_);
+        [[maybe_unused]] vector_detail::GrowthTrace<Storage> trace(data_, size_, sizeof(T), site);
+        if constexpr (HAS_INLINE_BUFFER) {
+            if (new_capacity <= Storage::INLINE_CAPACITY) {
+                if (data_.IsInline()) {
+                    return;
+                }
+                if constexpr (VECTOR_STATS_ENABLED) {
+                    CountReallocation();
+                }
+                HeapMemory old_data(GetAllocator());
+                data_.Swap(old_data);
+                try {
+                    RelocateToNewBuffer(old_data.GetAddress(), begin(), size_);
+                }
+                catch (...) {
+                    data_.Swap(old_data);
+                    throw;
+                }
+                return;
+            }
+        }
+
+        if constexpr (VECTOR_STATS_ENABLED) {
+            CountReallocation();
+        }
+
+        if constexpr (GROWS_IN_PLACE) {
+            if (!data_.IsInline() && new_capacity != 0) {
+                data_.Reallocate(new_capacity);
+                return;
+            }
+        }
+
+        HeapMemory new_data(new_capacity, GetAllocator());
+        RelocateToNewBuffer(begin(), new_data.GetAddress(), size_);
+        data_.Swap(new_data);
+    }
+
+    // applies the shrink rule of the growth policy if it has one; a failed shrink keeps the buffer
+    void ShrinkIfSparse(const vector_detail::TraceSite& site) noexcept {
+        if constexpr (HasShrinkCapacity<GrowthPolicy>::value) {
+            const size_t new_capacity = GrowthPolicy::ShrinkCapacity(size_, data_.Capacity(), sizeof(T));
+            if (new_capacity < data_.Capacity()) {
+                try {
+                    ChangeCapacity(new_capacity, site);
+                }
+                catch (...) {
+                }
+            }
+        }
+    }
+
+    static void CopyOrMoveToNewBuffer(T* from, T* to, size_t number) {
+        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+            ConstructItems(to, number, [from, to](size_t first, size_t count) {
+                std::uninitialized_move_n(from + first, count, to + first);
+            });
+            if constexpr (VECTOR_STATS_ENABLED) {
+                vector_detail::LocalStats().items_moved += number;
+            }
+        }
+        else {
+            ConstructItems(to, number, [from, to](size_t first, size_t count) {
+                std::uninitialized_copy_n(from + first, count, to + first);
+            });
+            if constexpr (VECTOR_STATS_ENABLED) {
+                vector_detail::LocalStats().items_copied += number;
+            }
+        }
+    }
+
+    // calls construct(first, number) that builds the items [first, first + number) at to; big vectors
+    // are built by several threads, see vector_parallel.h, and nothing is left if an exception is thrown
+    template <typename Constructor>
+    static void ConstructItems(T* to, size_t count, Constructor construct) {
+        vector_detail::ParallelConstruct(count, sizeof(T), construct, [to](size_t first, size_t number) {
+            std::destroy_n(to + first, number);
+        });
+    }
+
+    static void DestroyItems(T* items, size_t count) noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            vector_detail::ParallelDestroy(count, sizeof(T), [items](size_t first, size_t number) {
+                std::destroy_n(items + first, number);
+            });
+        }
+    }
+
+    static void CountReallocation() noexcept {
+        ++vector_detail::LocalStats().reallocations;
+    }
+
+    size_t CalcNewCapacity() const noexcept {
+        return GrowthPolicy::NewCapacity(data_.Capacity(), size_ + 1, sizeof(T));
+    }
+
+    template <typename... Args>
+    T* ReallocateMemoryAddingNewElement(const vector_detail::TraceSite& site, size_t index, Args&&... args) {
+        [[maybe_unused]] vector_detail::GrowthTrace<Storage> trace(data_, size_, sizeof(T), site);
+        if constexpr (VECTOR_STATS_ENABLED) {
+            CountReallocation();
+        }
+
+        if constexpr (GROWS_IN_PLACE) {
+            if (!data_.IsInline()) {
+                // the value is built aside as args may refer to an element of the old buffer
+                alignas(T) unsigned char temp_value[sizeof(T)];
+                T* temp_ptr = new (temp_value) T(std::forward<Args>(args)...);
+                try {
+                    data_.Reallocate(CalcNewCapacity());
+                }
+                catch (...) {
+                    temp_ptr->~T();
+                    throw;
+                }
+                std::memmove(static_cast<void*>(begin() + index + 1), begin() + index, (size_ - index) * sizeof(T));
+                std::memcpy(static_cast<void*>(begin() + index), temp_ptr, sizeof(T));
+                ++size_;
+                return begin() + index;
+            }
+        }
+
+        HeapMemory new_data(CalcNewCapacity(), GetAllocator());
+        T* ptr = new (new_data + index) T(std::forward<Args>(args)...);
+        RelocateAroundGap(new_data, index, 1);
         data_.Swap(new_data);
         ++size_;
         return ptr;
@@ -0,0 +1,426 @@
+#pragma once
+#include "vector.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+// Bulk operations over a Vector with SIMD kernels for int, float and double. The kernels are
+// selected at runtime: SSE2, AVX2 or AVX-512 on x86, NEON on ARM; other item types, other
+// compilers and other CPUs use scalar loops.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VECTOR_SIMD_X86
+#elif defined(__GNUC__) && defined(__ARM_NEON)
+#define VECTOR_SIMD_NEON
+#endif
+
+// VECTOR_128 means SSE2 on x86 and NEON on ARM
+enum class SimdLevel {
+    SCALAR,
+    VECTOR_128,
+    AVX2,
+    AVX512,
+};
+
+// min and max for Reduce, they use the same comparison as the SIMD kernels
+struct Minimum {
+    template <typename T>
+    T operator()(T lhs, T rhs) const {
+        return rhs < lhs ? rhs : lhs;
+    }
+};
+
+struct Maximum {
+    template <typename T>
+    T operator()(T lhs, T rhs) const {
+        return lhs < rhs ? rhs : lhs;
+    }
+};
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+// vectors are passed only between always inlined functions
+#pragma GCC diagnostic ignored "-Wpsabi"
+#define VECTOR_SIMD_INLINE inline __attribute__((always_inline))
+#else
+#define VECTOR_SIMD_INLINE inline
+#endif
+
+namespace vector_detail {
+
+    inline SimdLevel DetectSimdLevel() noexcept {
+#if defined(VECTOR_SIMD_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return SimdLevel::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::AVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return SimdLevel::VECTOR_128;
+        }
+        return SimdLevel::SCALAR;
+#elif defined(VECTOR_SIMD_NEON)
+        return SimdLevel::VECTOR_128;
+#else
+        return SimdLevel::SCALAR;
+#endif
+    }
+
+    inline SimdLevel SupportedSimdLevel() noexcept {
+        static const SimdLevel level = DetectSimdLevel();
+        return level;
+    }
+
+    inline std::atomic<SimdLevel>& ActiveSimdLevel() noexcept {
+        static std::atomic<SimdLevel> level{ SupportedSimdLevel() };
+        return level;
+    }
+
+    template <typename T>
+    inline constexpr bool IS_SIMD_ITEM = std::is_same_v<T, int> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+    enum class ReduceKind {
+        GENERIC,
+        SUM,
+        MIN,
+        MAX,
+    };
+
+    template <typename T, typename Op>
+    inline constexpr ReduceKind REDUCE_KIND_OF
+        = std::is_same_v<Op, std::plus<T>> || std::is_same_v<Op, std::plus<>> ? ReduceKind::SUM
+        : std::is_same_v<Op, Minimum> ? ReduceKind::MIN
+        : std::is_same_v<Op, Maximum> ? ReduceKind::MAX
+        : ReduceKind::GENERIC;
+
+    // one source of truth for scalars and vectors, so every level gives the same result for min and max
+    template <ReduceKind KIND, typename U>
+    VECTOR_SIMD_INLINE void CombineInto(U& acc, const U& item) {
+        if constexpr (KIND == ReduceKind::SUM) {
+            acc = acc + item;
+        }
+        else if constexpr (KIND == ReduceKind::MIN) {
+            acc = item < acc ? item : acc;
+        }
+        else {
+            acc = acc < item ? item : acc;
+        }
+    }
+
+    // every kernel has a scalar version and a SIMD version for vectors of BYTES bytes which
+    // is always inlined into a function compiled for the selected instruction set
+    struct FillKernel {
+        template <typename T>
+        static void Scalar(T* data, size_t size, T value) {
+            std::fill_n(data, size, value);
+        }
+
+        template <size_t BYTES, typename T>
+        static void Simd(T* data, size_t size, T value);
+    };
+
+    struct FindKernel {
+        template <typename T>
+        static size_t Scalar(const T* data, size_t size, T value) {
+            return std::find(data, data + size, value) - data;
+        }
+
+        template <size_t BYTES, typename T>
+        static size_t Simd(const T* data, size_t size, T value);
+    };
+
+    struct CountKernel {
+        template <typename T>
+        static size_t Scalar(const T* data, size_t size, T value) {
+            return std::count(data, data + size, value);
+        }
+
+        template <size_t BYTES, typename T>
+        static size_t Simd(const T* data, size_t size, T value);
+    };
+
+    template <ReduceKind KIND>
+    struct ReduceKernel {
+        template <typename T>
+        static T Scalar(const T* data, size_t size, T init) {
+            for (size_t i = 0; i < size; ++i) {
+                CombineInto<KIND>(init, data[i]);
+            }
+            return init;
+        }
+
+        template <size_t BYTES, typename T>
+        static T Simd(const T* data, size_t size, T init);
+    };
+
+    template <typename Op>
+    struct TransformKernel {
+        template <typename T>
+        static void Scalar(const T* from, T* to, size_t size, Op& op) {
+            for (size_t i = 0; i < size; ++i) {
+                to[i] = op(from[i]);
+            }
+        }
+
+        template <size_t BYTES, typename T>
+        static void Simd(const T* from, T* to, size_t size, Op& op);
+    };
+
+#if defined(VECTOR_SIMD_X86) || defined(VECTOR_SIMD_NEON)
+    template <typename T, size_t BYTES>
+    struct SimdVectorType {
+        typedef T type __attribute__((vector_size(BYTES)));
+    };
+
+    template <typename T, size_t BYTES>
+    using SimdVector = typename SimdVectorType<T, BYTES>::type;
+
+    template <typename V, typename T>
+    VECTOR_SIMD_INLINE V LoadSimd(const T* from) {
+        V result;
+        std::memcpy(&result, from, sizeof(V));
+        return result;
+    }
+
+    // lanes of a comparison result are either zero or all ones
+    template <typename Mask>
+    VECTOR_SIMD_INLINE bool AnyLane(const Mask& mask) {
+        using Words = SimdVector<uint64_t, sizeof(Mask)>;
+        Words words = LoadSimd<Words>(&mask);
+        uint64_t any = 0;
+        for (size_t i = 0; i < sizeof(Mask) / sizeof(uint64_t); ++i) {
+            any |= words[i];
+        }
+        return any != 0;
+    }
+
+    template <size_t BYTES, typename T>
+    VECTOR_SIMD_INLINE void FillKernel::Simd(T* data, size_t size, T value) {
+        using V = SimdVector<T, BYTES>;
+        constexpr size_t LANES = BYTES / sizeof(T);
+        const V values = V{} + value;
+        size_t i = 0;
+        for (; i + LANES <= size; i += LANES) {
+            std::memcpy(data + i, &values, sizeof(V));
+        }
+        Scalar(data + i, size - i, value);
+    }
+
+    template <size_t BYTES, typename T>
+    VECTOR_SIMD_INLINE size_t FindKernel::Simd(const T* data, size_t size, T value) {
+        using V = SimdVector<T, BYTES>;
+        constexpr size_t LANES = BYTES / sizeof(T);
+        const V values = V{} + value;
+        size_t i = 0;
+        while (i + LANES <= size && !AnyLane(LoadSimd<V>(data + i) == values)) {
+            i += LANES;
+        }
+        return i + Scalar(data + i, size - i, value);
+    }
+
+    template <size_t BYTES, typename T>
+    VECTOR_SIMD_INLINE size_t CountKernel::Simd(const T* data, size_t size, T value) {
+        using V = SimdVector<T, BYTES>;
+        using Mask = decltype(V{} == V{});
+        constexpr size_t LANES = BYTES / sizeof(T);
+        // lanes of 32 bits are flushed before they can overflow
+        constexpr size_t MAX_STEPS = size_t{ 1 } << 30;
+        const V values = V{} + value;
+        size_t i = 0;
+        size_t result = 0;
+        while (i + LANES <= size) {
+            Mask counts{};
+            for (size_t steps = 0; steps < MAX_STEPS && i + LANES <= size; ++steps, i += LANES) {
+                // a match is -1
+                counts -= LoadSimd<V>(data + i) == values;
+            }
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                result += static_cast<size_t>(counts[lane]);
+            }
+        }
+        return result + Scalar(data + i, size - i, value);
+    }
+
+    template <ReduceKind KIND>
+    template <size_t BYTES, typename T>
+    VECTOR_SIMD_INLINE T ReduceKernel<KIND>::Simd(const T* data, size_t size, T init) {
+        using V = SimdVector<T, BYTES>;
+        constexpr size_t LANES = BYTES / sizeof(T);
+        if (size < LANES) {
+            return Scalar(data, size, init);
+        }
+        // -0.0 keeps the sign of a sum of negative zeros, min and max may start from any item
+        T identity = data[0];
+        if constexpr (KIND == ReduceKind::SUM) {
+            identity = std::is_floating_point_v<T> ? T(-0.0) : T(0);
+        }
+        // independent accumulators hide the latency of the operation
+        V acc0 = V{} + identity;
+        V acc1 = acc0;
+        V acc2 = acc0;
+        V acc3 = acc0;
+        size_t i = 0;
+        for (; i + 4 * LANES <= size; i += 4 * LANES) {
+            CombineInto<KIND>(acc0, LoadSimd<V>(data + i));
+            CombineInto<KIND>(acc1, LoadSimd<V>(data + i + LANES));
+            CombineInto<KIND>(acc2, LoadSimd<V>(data + i + 2 * LANES));
+            CombineInto<KIND>(acc3, LoadSimd<V>(data + i + 3 * LANES));
+        }
+        for (; i + LANES <= size; i += LANES) {
+            CombineInto<KIND>(acc0, LoadSimd<V>(data + i));
+        }
+        CombineInto<KIND>(acc0, acc1);
+        CombineInto<KIND>(acc2, acc3);
+        CombineInto<KIND>(acc0, acc2);
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            CombineInto<KIND>(init, static_cast<T>(acc0[lane]));
+        }
+        return Scalar(data + i, size - i, init);
+    }
+
+    // op is applied to scalars, the compiler turns each block of independent calls into vector code
+    template <typename Op>
+    template <size_t BYTES, typename T>
+    VECTOR_SIMD_INLINE void TransformKernel<Op>::Simd(const T* from, T* to, size_t size, Op& op) {
+        constexpr size_t LANES = BYTES / sizeof(T);
+        size_t i = 0;
+        for (; i + LANES <= size; i += LANES) {
+            T block[LANES];
+#pragma GCC unroll 16
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                block[lane] = op(from[i + lane]);
+            }
+            std::memcpy(to + i, block, sizeof(block));
+        }
+        Scalar(from + i, to + i, size - i, op);
+    }
+
+#if defined(VECTOR_SIMD_X86)
+    template <typename Kernel, typename T, typename... Args>
+    __attribute__((target("avx512f"))) auto RunAvx512(T* data, Args&&... args) {
+        return Kernel::template Simd<64>(data, std::forward<Args>(args)...);
+    }
+
+    template <typename Kernel, typename T, typename... Args>
+    __attribute__((target("avx2"))) auto RunAvx2(T* data, Args&&... args) {
+        return Kernel::template Simd<32>(data, std::forward<Args>(args)...);
+    }
+
+    template <typename Kernel, typename T, typename... Args>
+    __attribute__((target("sse2"))) auto RunSse2(T* data, Args&&... args) {
+        return Kernel::template Simd<16>(data, std::forward<Args>(args)...);
+    }
+#endif
+
+#endif
+
+    template <typename Kernel, typename T, typename... Args>
+    auto Dispatch(T* data, Args&&... args) {
+        if constexpr (IS_SIMD_ITEM<std::remove_const_t<T>>) {
+            switch (ActiveSimdLevel().load(std::memory_order_relaxed)) {
+#if defined(VECTOR_SIMD_X86)
+            case SimdLevel::AVX512:
+                return RunAvx512<Kernel>(data, std::forward<Args>(args)...);
+            case SimdLevel::AVX2:
+                return RunAvx2<Kernel>(data, std::forward<Args>(args)...);
+            case SimdLevel::VECTOR_128:
+                return RunSse2<Kernel>(data, std::forward<Args>(args)...);
+#elif defined(VECTOR_SIMD_NEON)
+            case SimdLevel::VECTOR_128:
+                return Kernel::template Simd<16>(data, std::forward<Args>(args)...);
+#endif
+            default:
+                break;
+            }
+        }
+        return Kernel::Scalar(data, std::forward<Args>(args)...);
+    }
+
+}  // namespace vector_detail
+
+#undef VECTOR_SIMD_INLINE
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+// the best level supported by the CPU
+inline SimdLevel GetSupportedSimdLevel() noexcept {
+    return vector_detail::SupportedSimdLevel();
+}
+
+inline SimdLevel GetSimdLevel() noexcept {
+    return vector_detail::ActiveSimdLevel().load(std::memory_order_relaxed);
+}
+
+// limits the kernels used by all threads, e.g. to compare the levels or to avoid
+// the frequency drop of AVX-512; levels above the supported one are ignored
+inline void SetSimdLevel(SimdLevel level) noexcept {
+    vector_detail::ActiveSimdLevel().store(std::min(level, GetSupportedSimdLevel()), std::memory_order_relaxed);
+}
+
+// assigns value to every item
+template <typename T, typename... Params>
+void Fill(Vector<T, Params...>& vector, T value) {
+    vector_detail::Dispatch<vector_detail::FillKernel>(vector.Data(), vector.Size(), value);
+}
+
+// returns the first item equal to value or end()
+template <typename T, typename... Params>
+typename Vector<T, Params...>::iterator Find(Vector<T, Params...>& vector, T value) {
+    return vector.begin() + vector_detail::Dispatch<vector_detail::FindKernel>(vector.Data(), vector.Size(), value);
+}
+
+template <typename T, typename... Params>
+typename Vector<T, Params...>::const_iterator Find(const Vector<T, Params...>& vector, T value) {
+    return vector.begin() + vector_detail::Dispatch<vector_detail::FindKernel>(vector.Data(), vector.Size(), value);
+}
+
+template <typename T, typename... Params>
+size_t Count(const Vector<T, Params...>& vector, T value) {
+    return vector_detail::Dispatch<vector_detail::CountKernel>(vector.Data(), vector.Size(), value);
+}
+
+// folds the items into init with op; std::plus, Minimum and Maximum run SIMD kernels that
+// combine the items in a different order than a loop does, so a float sum may differ
+// in the last bits and min or max of items with NaN is unspecified
+template <typename T, typename Op, typename... Params>
+T Reduce(const Vector<T, Params...>& vector, T init, Op op) {
+    constexpr vector_detail::ReduceKind KIND = vector_detail::REDUCE_KIND_OF<T, Op>;
+    if constexpr (KIND == vector_detail::ReduceKind::GENERIC) {
+        for (const T& item : vector) {
+            init = op(std::move(init), item);
+        }
+        return init;
+    }
+    else {
+        return vector_detail::Dispatch<vector_detail::ReduceKernel<KIND>>(vector.Data(), vector.Size(), init);
+    }
+}
+
+// sum of the items
+template <typename T, typename... Params>
+T Reduce(const Vector<T, Params...>& vector) {
+    return Reduce(vector, T{}, std::plus<>{});
+}
+
+// replaces every item with op(item)
+template <typename T, typename Op, typename... Params>
+void Transform(Vector<T, Params...>& vector, Op op) {
+    vector_detail::Dispatch<vector_detail::TransformKernel<Op>>(std::as_const(vector).Data(), vector.Data(), vector.Size(), op);
+}
+
+// makes to hold op(item) for every item of from, to may be from itself
+template <typename T, typename Op, typename... FromParams, typename... ToParams>
+void Transform(const Vector<T, FromParams...>& from, Vector<T, ToParams...>& to, Op op) {
+    if constexpr (std::is_trivial_v<T>) {
+        to.ResizeDefaultInit(from.Size());
+    }
+    else {
+        to.Resize(from.Size());
+    }
+    vector_detail::Dispatch<vector_detail::TransformKernel<Op>>(from.Data(), to.Data(), from.Size(), op);
+}
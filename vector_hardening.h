@@ -0,0 +1,229 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iterator>
+#include <type_traits>
+
+// Checked mode of Vector, selected by defining VECTOR_HARDENED. It adds checks that work in
+// release builds and stop the program with a message on a failure:
+// - bounds checks of operator[], PopBack, the positions of Insert/Emplace/Erase and of RawMemory;
+// - iterators that know their vector and its generation, which changes whenever the items move to
+//   another buffer, so an iterator used after a reallocation is caught; iterators belong to the vector
+//   object, so they are invalidated by Swap and by moving the vector too;
+// - under AddressSanitizer the unused capacity of vectors is annotated as a container overflow region,
+//   so raw pointers that reach past the size are caught as well.
+// Without VECTOR_HARDENED none of it is compiled and iterators are plain pointers.
+
+#ifdef VECTOR_HARDENED
+inline constexpr bool VECTOR_HARDENED_ENABLED = true;
+#else
+inline constexpr bool VECTOR_HARDENED_ENABLED = false;
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define VECTOR_ASAN_ENABLED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define VECTOR_ASAN_ENABLED 1
+#endif
+#endif
+
+#if defined(VECTOR_HARDENED) && defined(VECTOR_ASAN_ENABLED)
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+namespace vector_detail {
+
+    [[noreturn]] inline void HardeningFailure(const char* what) noexcept {
+        std::fprintf(stderr, "Vector check failed: %s\n", what);
+        std::abort();
+    }
+
+    inline void HardeningCheck(bool condition, const char* what) noexcept {
+        if constexpr (VECTOR_HARDENED_ENABLED) {
+            if (!condition) {
+                HardeningFailure(what);
+            }
+        }
+    }
+
+    // makes [mid, end) of the buffer [begin, end) inaccessible for AddressSanitizer and [begin, mid)
+    // accessible whatever the previous annotation was; only the whole 8 byte granules of the shadow memory
+    // are annotated, as the rest of the last one may belong to a neighbouring block, e.g. of an arena,
+    // and buffers that don't start at a granule are left alone
+    inline void AnnotateBuffer([[maybe_unused]] const void* begin, [[maybe_unused]] const void* end,
+                               [[maybe_unused]] const void* mid) noexcept {
+#if defined(VECTOR_HARDENED) && defined(VECTOR_ASAN_ENABLED)
+        const auto* first = static_cast<const unsigned char*>(begin);
+        const unsigned char* last = first + (static_cast<const unsigned char*>(end) - first) / 8 * 8;
+        if (first == last || reinterpret_cast<uintptr_t>(first) % 8 != 0) {
+            return;
+        }
+        const unsigned char* accessible = std::min(static_cast<const unsigned char*>(mid), last);
+        __sanitizer_annotate_contiguous_container(first, last, first, last);
+        __sanitizer_annotate_contiguous_container(first, last, last, accessible);
+#endif
+    }
+
+    // the state a vector keeps in the checked mode, an empty base otherwise
+    template <bool ENABLED = VECTOR_HARDENED_ENABLED>
+    struct HardeningState {
+        // changes whenever the vector is seen with another buffer or capacity than before
+        mutable size_t generation = 0;
+        mutable const void* seen_buffer = nullptr;
+        mutable size_t seen_capacity = 0;
+        // number of the operations of the vector that are running, they may call each other
+        unsigned operation_depth = 0;
+    };
+
+    template <>
+    struct HardeningState<false> {
+    };
+
+    // iterator of the checked mode; it converts to a plain pointer for code that needs one,
+    // that conversion is not checked
+    template <typename T, typename Owner>
+    class CheckedIterator {
+        using NonConstIterator = CheckedIterator<std::remove_const_t<T>, Owner>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::remove_const_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        CheckedIterator() = default;
+
+        CheckedIterator(T* ptr, const Owner* owner) noexcept
+            : ptr_(ptr)
+            , owner_(owner)
+            , generation_(owner->Generation()) {
+        }
+
+        // iterator converts to const_iterator
+        template <typename U = T, typename = std::enable_if_t<std::is_const_v<U>>>
+        CheckedIterator(const NonConstIterator& other) noexcept
+            : ptr_(other.ptr_)
+            , owner_(other.owner_)
+            , generation_(other.generation_) {
+        }
+
+        operator T*() const noexcept {
+            return ptr_;
+        }
+
+        T& operator*() const noexcept {
+            CheckAccess(ptr_);
+            return *ptr_;
+        }
+
+        T* operator->() const noexcept {
+            CheckAccess(ptr_);
+            return ptr_;
+        }
+
+        T& operator[](difference_type offset) const noexcept {
+            CheckAccess(ptr_ + offset);
+            return ptr_[offset];
+        }
+
+        CheckedIterator& operator++() noexcept {
+            ++ptr_;
+            return *this;
+        }
+
+        CheckedIterator operator++(int) noexcept {
+            CheckedIterator old = *this;
+            ++ptr_;
+            return old;
+        }
+
+        CheckedIterator& operator--() noexcept {
+            --ptr_;
+            return *this;
+        }
+
+        CheckedIterator operator--(int) noexcept {
+            CheckedIterator old = *this;
+            --ptr_;
+            return old;
+        }
+
+        CheckedIterator& operator+=(difference_type offset) noexcept {
+            ptr_ += offset;
+            return *this;
+        }
+
+        CheckedIterator& operator-=(difference_type offset) noexcept {
+            ptr_ -= offset;
+            return *this;
+        }
+
+        // integral offsets of any type, so these are preferred to the built-in pointer arithmetic
+        template <typename Int, typename = std::enable_if_t<std::is_integral_v<Int>>>
+        friend CheckedIterator operator+(CheckedIterator it, Int offset) noexcept {
+            return it += static_cast<difference_type>(offset);
+        }
+
+        template <typename Int, typename = std::enable_if_t<std::is_integral_v<Int>>>
+        friend CheckedIterator operator+(Int offset, CheckedIterator it) noexcept {
+            return it += static_cast<difference_type>(offset);
+        }
+
+        template <typename Int, typename = std::enable_if_t<std::is_integral_v<Int>>>
+        friend CheckedIterator operator-(CheckedIterator it, Int offset) noexcept {
+            return it -= static_cast<difference_type>(offset);
+        }
+
+        friend difference_type operator-(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            HardeningCheck(lhs.owner_ == rhs.owner_, "iterators of different vectors are compared");
+            return lhs.ptr_ - rhs.ptr_;
+        }
+
+        friend bool operator==(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ == rhs.ptr_;
+        }
+
+        friend bool operator!=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ != rhs.ptr_;
+        }
+
+        friend bool operator<(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return lhs.ptr_ < rhs.ptr_;
+        }
+
+        friend bool operator>(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return rhs < lhs;
+        }
+
+        friend bool operator<=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return !(rhs < lhs);
+        }
+
+        friend bool operator>=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+            return !(lhs < rhs);
+        }
+
+    private:
+        template <typename U, typename OtherOwner>
+        friend class CheckedIterator;
+
+        // the vector itself writes through iterators into its unused capacity, so the capacity is
+        // the bound here; the sanitizer annotations catch accesses past the size
+        void CheckAccess(const T* ptr) const noexcept {
+            HardeningCheck(owner_ != nullptr, "singular iterator is dereferenced");
+            HardeningCheck(generation_ == owner_->Generation(), "iterator is used after a reallocation");
+            HardeningCheck(owner_->IsInCapacity(ptr), "iterator is out of range");
+        }
+
+        T* ptr_ = nullptr;
+        const Owner* owner_ = nullptr;
+        size_t generation_ = 0;
+    };
+
+}  // namespace vector_detail
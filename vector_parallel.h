@@ -0,0 +1,127 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <new>
+#include <thread>
+
+// Construction, copying, relocation and destruction of the items of big vectors may be split
+// between threads. It is off by default: constructors and destructors of different items run
+// concurrently then, so they must not touch shared state without synchronization.
+
+namespace vector_detail {
+
+    inline std::atomic<size_t> min_bytes_per_thread{ std::numeric_limits<size_t>::max() };
+    inline std::atomic<size_t> max_threads{ 0 };
+
+    // number of threads for count items, 1 below the threshold
+    inline size_t ParallelChunks(size_t count, size_t item_size) noexcept {
+        const size_t min_bytes = min_bytes_per_thread.load(std::memory_order_relaxed);
+        const size_t bytes = count * item_size;
+        if (bytes < min_bytes || bytes / min_bytes < 2) {
+            return 1;
+        }
+        size_t threads = max_threads.load(std::memory_order_relaxed);
+        if (threads == 0) {
+            threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+        return std::min({ threads, bytes / min_bytes, count });
+    }
+
+    // index of the first item of a chunk, the sizes of the chunks differ at most by one
+    inline size_t ChunkBegin(size_t count, size_t chunks, size_t chunk) noexcept {
+        return count / chunks * chunk + std::min(chunk, count % chunks);
+    }
+
+    // calls body(chunk, first, number) for every chunk of [0, count), the first chunk runs on the
+    // current thread; if a thread can't be started its chunk runs on the current thread too
+    template <typename Body>
+    void RunChunks(size_t count, size_t chunks, Body& body) noexcept {
+        std::unique_ptr<std::thread[]> threads(new (std::nothrow) std::thread[chunks]);
+        for (size_t chunk = 1; chunk < chunks; ++chunk) {
+            const size_t first = ChunkBegin(count, chunks, chunk);
+            const size_t number = ChunkBegin(count, chunks, chunk + 1) - first;
+            try {
+                if (!threads) {
+                    throw std::bad_alloc();
+                }
+                threads[chunk] = std::thread([&body, chunk, first, number] {
+                    body(chunk, first, number);
+                });
+            }
+            catch (...) {
+                body(chunk, first, number);
+            }
+        }
+        body(0, 0, ChunkBegin(count, chunks, 1));
+        if (threads) {
+            for (size_t chunk = 1; chunk < chunks; ++chunk) {
+                if (threads[chunk].joinable()) {
+                    threads[chunk].join();
+                }
+            }
+        }
+    }
+
+    // constructs count items of item_size bytes with construct(first, number), which has to build
+    // all items of [first, first + number) or none of them; if an exception is thrown, the chunks
+    // built successfully are destroyed with destroy(first, number) and the first exception is rethrown
+    template <typename Constructor, typename Destructor>
+    void ParallelConstruct(size_t count, size_t item_size, Constructor construct, Destructor destroy) {
+        const size_t chunks = ParallelChunks(count, item_size);
+        if (chunks == 1) {
+            construct(size_t{ 0 }, count);
+            return;
+        }
+        std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[chunks]);
+        auto body = [&](size_t chunk, size_t first, size_t number) {
+            try {
+                construct(first, number);
+            }
+            catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+        };
+        RunChunks(count, chunks, body);
+
+        const auto failed = std::find_if(errors.get(), errors.get() + chunks, [](const std::exception_ptr& error) {
+            return error != nullptr;
+        });
+        if (failed == errors.get() + chunks) {
+            return;
+        }
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            if (!errors[chunk]) {
+                const size_t first = ChunkBegin(count, chunks, chunk);
+                destroy(first, ChunkBegin(count, chunks, chunk + 1) - first);
+            }
+        }
+        std::rethrow_exception(*failed);
+    }
+
+    // calls destroy(first, number) for the chunks of [0, count)
+    template <typename Destructor>
+    void ParallelDestroy(size_t count, size_t item_size, Destructor destroy) noexcept {
+        const size_t chunks = ParallelChunks(count, item_size);
+        if (chunks == 1) {
+            destroy(size_t{ 0 }, count);
+            return;
+        }
+        auto body = [&destroy](size_t /*chunk*/, size_t first, size_t number) {
+            destroy(first, number);
+        };
+        RunChunks(count, chunks, body);
+    }
+
+}  // namespace vector_detail
+
+// splits the work on the items of a vector between threads once it has at least two times
+// min_bytes_per_thread bytes of items, using up to max_threads threads (0 means one per hardware
+// thread); the maximum of size_t turns it off, which is the default
+inline void SetVectorParallelism(size_t min_bytes_per_thread, size_t max_threads = 0) noexcept {
+    vector_detail::min_bytes_per_thread.store(std::max<size_t>(min_bytes_per_thread, 1), std::memory_order_relaxed);
+    vector_detail::max_threads.store(max_threads, std::memory_order_relaxed);
+}
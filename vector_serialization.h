@@ -0,0 +1,233 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Binary format of a vector of trivially copyable items: a 32 byte header and the bytes of the
+// items as they are in memory. The byte order and the layout of T have to be the same on the
+// reading side; a reader with another byte order fails on the magic number.
+
+struct SerializedVectorHeader {
+    static constexpr uint32_t MAGIC = 0x56454331;  // "VEC1"
+    static constexpr uint16_t VERSION = 1;
+
+    uint32_t magic = MAGIC;
+    uint16_t version = VERSION;
+    uint16_t reserved = 0;
+    uint32_t item_size = 0;
+    uint32_t item_alignment = 0;
+    uint64_t size = 0;
+    uint64_t padding = 0;
+};
+
+static_assert(sizeof(SerializedVectorHeader) == 32, "the items follow the header at an offset of 32 bytes");
+
+// read-only view of items that belong to someone else
+template <typename T>
+class VectorView {
+public:
+    using value_type = T;
+    using iterator = const T*;
+    using const_iterator = const T*;
+
+    VectorView() = default;
+
+    VectorView(const T* data, size_t size) noexcept
+        : data_(data)
+        , size_(size) {
+    }
+
+    template <typename... Params>
+    VectorView(const Vector<T, Params...>& vector) noexcept
+        : VectorView(vector.Data(), vector.Size()) {
+    }
+
+    const T* begin() const noexcept {
+        return data_;
+    }
+
+    const T* end() const noexcept {
+        return data_ + size_;
+    }
+
+    const T* Data() const noexcept {
+        return data_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return data_[index];
+    }
+
+private:
+    const T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+namespace vector_detail {
+
+    // the first part of the payload read into the vector, the next ones double it
+    inline constexpr size_t SERIALIZED_READ_CHUNK_BYTES = size_t{ 1 } << 20;
+
+    [[noreturn]] inline void ThrowSerializationError(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    template <typename T>
+    SerializedVectorHeader MakeSerializedHeader(size_t size) noexcept {
+        SerializedVectorHeader header;
+        header.item_size = sizeof(T);
+        header.item_alignment = alignof(T);
+        header.size = size;
+        return header;
+    }
+
+    template <typename T>
+    void CheckSerializedHeader(const SerializedVectorHeader& header) {
+        if (header.magic != SerializedVectorHeader::MAGIC || header.version != SerializedVectorHeader::VERSION) {
+            throw std::runtime_error("not a serialized vector or another byte order");
+        }
+        if (header.item_size != sizeof(T) || header.item_alignment != alignof(T)) {
+            throw std::runtime_error("serialized vector of another item type");
+        }
+        if (header.size > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::length_error("serialized vector is too long");
+        }
+    }
+
+    // reads exactly size bytes unless the end of the file comes first
+    inline void ReadFully(int fd, void* to, size_t size) {
+        auto* bytes = static_cast<unsigned char*>(to);
+        while (size != 0) {
+            const ssize_t read_bytes = read(fd, bytes, size);
+            if (read_bytes < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ThrowSerializationError("read");
+            }
+            if (read_bytes == 0) {
+                throw std::runtime_error("serialized vector is cut short");
+            }
+            bytes += read_bytes;
+            size -= static_cast<size_t>(read_bytes);
+        }
+    }
+
+}  // namespace vector_detail
+
+template <typename T, typename... Params>
+size_t SerializedSize(const Vector<T, Params...>& vector) noexcept {
+    return sizeof(SerializedVectorHeader) + vector.Size() * sizeof(T);
+}
+
+// writes SerializedSize(vector) bytes to out
+template <typename T, typename... Params>
+void SerializeVector(const Vector<T, Params...>& vector, void* out) noexcept {
+    static_assert(std::is_trivially_copyable_v<T>, "only the bytes of the items are written");
+    const SerializedVectorHeader header = vector_detail::MakeSerializedHeader<T>(vector.Size());
+    std::memcpy(out, &header, sizeof(header));
+    if (vector.Size() != 0) {
+        std::memcpy(static_cast<unsigned char*>(out) + sizeof(header), vector.Data(), vector.Size() * sizeof(T));
+    }
+}
+
+// writes the header and the items with one writev call in the common case,
+// the items go to the kernel straight from the buffer of the vector
+template <typename T, typename... Params>
+void WriteVector(int fd, const Vector<T, Params...>& vector) {
+    static_assert(std::is_trivially_copyable_v<T>, "only the bytes of the items are written");
+    SerializedVectorHeader header = vector_detail::MakeSerializedHeader<T>(vector.Size());
+    iovec parts[2] = {
+        { &header, sizeof(header) },
+        { const_cast<T*>(vector.Data()), vector.Size() * sizeof(T) },
+    };
+    iovec* part = parts;
+    int num_parts = vector.Size() == 0 ? 1 : 2;
+    while (num_parts != 0) {
+        const ssize_t written = writev(fd, part, num_parts);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            vector_detail::ThrowSerializationError("writev");
+        }
+        // a partial write goes on from where it stopped
+        auto left = static_cast<size_t>(written);
+        while (num_parts != 0 && left >= part->iov_len) {
+            left -= part->iov_len;
+            ++part;
+            --num_parts;
+        }
+        if (num_parts != 0) {
+            part->iov_base = static_cast<unsigned char*>(part->iov_base) + left;
+            part->iov_len -= left;
+        }
+    }
+}
+
+// replaces the items of vector with at most max_size items read from fd, the payload is read
+// straight into the buffer of the vector; vector is left empty if an exception is thrown.
+// The size in the header is not trusted: the buffer grows in doubling parts as the items arrive,
+// so a corrupt or cut short input costs at most about twice the bytes it really has
+template <typename T, typename... Params>
+void ReadVector(int fd, Vector<T, Params...>& vector, size_t max_size = std::numeric_limits<size_t>::max()) {
+    static_assert(std::is_trivially_copyable_v<T>, "only the bytes of the items are read");
+    // the old items go first, so a bad header doesn't leave them behind
+    vector.Clear();
+    SerializedVectorHeader header;
+    vector_detail::ReadFully(fd, &header, sizeof(header));
+    vector_detail::CheckSerializedHeader<T>(header);
+    if (header.size > max_size) {
+        throw std::length_error("serialized vector is longer than max_size");
+    }
+    const auto size = static_cast<size_t>(header.size);
+    try {
+        // the capacity the vector already has costs nothing
+        const size_t first_chunk = std::max<size_t>(vector_detail::SERIALIZED_READ_CHUNK_BYTES / sizeof(T), 1);
+        size_t chunk = std::max(vector.Capacity(), first_chunk);
+        while (vector.Size() < size) {
+            const size_t read_size = vector.Size();
+            vector.ResizeDefaultInit(read_size + std::min(chunk, size - read_size));
+            vector_detail::ReadFully(fd, vector.Data() + read_size, (vector.Size() - read_size) * sizeof(T));
+            chunk = vector.Size();
+        }
+    }
+    catch (...) {
+        vector.Clear();
+        throw;
+    }
+}
+
+// view of the items of a serialized vector in memory, e.g. in a received or mapped buffer;
+// nothing is copied, so bytes have to outlive the view and be aligned for T
+template <typename T>
+VectorView<T> ViewSerializedVector(const void* bytes, size_t size) {
+    static_assert(std::is_trivially_copyable_v<T>, "items are viewed in place");
+    if (size < sizeof(SerializedVectorHeader)) {
+        throw std::runtime_error("serialized vector is cut short");
+    }
+    SerializedVectorHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    vector_detail::CheckSerializedHeader<T>(header);
+    if (header.size > (size - sizeof(header)) / sizeof(T)) {
+        throw std::runtime_error("serialized vector is cut short");
+    }
+    const auto* items = static_cast<const unsigned char*>(bytes) + sizeof(header);
+    if (reinterpret_cast<uintptr_t>(items) % alignof(T) != 0) {
+        throw std::invalid_argument("serialized items are not aligned for T");
+    }
+    return VectorView<T>(reinterpret_cast<const T*>(items), static_cast<size_t>(header.size));
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Counters of the memory traffic of RawMemory and Vector. They are collected per thread
+// only if VECTOR_ENABLE_STATS is defined, otherwise the counting code is not compiled at all.
+
+#ifdef VECTOR_ENABLE_STATS
+inline constexpr bool VECTOR_STATS_ENABLED = true;
+#else
+inline constexpr bool VECTOR_STATS_ENABLED = false;
+#endif
+
+struct VectorStats {
+    size_t allocations = 0;
+    size_t bytes_allocated = 0;
+    // new buffers for the items of a vector: growth, Reserve, ShrinkToFit
+    size_t reallocations = 0;
+    size_t items_moved = 0;
+    // items copied to a new buffer because their move constructor may throw
+    size_t items_copied = 0;
+    // trivially relocatable items copied with memcpy
+    size_t items_relocated = 0;
+    size_t peak_capacity_bytes = 0;
+};
+
+using VectorStatsExporter = void (*)(const VectorStats& stats);
+
+namespace vector_detail {
+
+    inline std::atomic<VectorStatsExporter> stats_exporter{ nullptr };
+
+    struct ThreadStats {
+        ~ThreadStats() {
+            if (VectorStatsExporter exporter = stats_exporter.load()) {
+                exporter(stats);
+            }
+        }
+
+        VectorStats stats;
+    };
+
+    inline VectorStats& LocalStats() noexcept {
+        thread_local ThreadStats thread_stats;
+        return thread_stats.stats;
+    }
+
+}  // namespace vector_detail
+
+// returns the counters of the current thread
+inline VectorStats GetVectorStats() noexcept {
+    return vector_detail::LocalStats();
+}
+
+inline void ResetVectorStats() noexcept {
+    vector_detail::LocalStats() = VectorStats{};
+}
+
+// exporter is called with the final counters of each thread that used the counters when it exits
+inline void SetVectorStatsExporter(VectorStatsExporter exporter) noexcept {
+    vector_detail::stats_exporter.store(exporter);
+}
@@ -0,0 +1,280 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define VECTOR_TRACE_TSC
+#endif
+
+// Trace of the growths of Vector buffers for finding the call sites that need a Reserve. It is
+// collected per thread only if VECTOR_ENABLE_TRACE is defined, otherwise the tracing code is not
+// compiled at all. Each new buffer of a vector is an event with the call site of the public method
+// that caused it, the old and the new capacity, the number of relocated items and the time spent.
+// Every method of Vector that may change the capacity takes the call site as a defaulted last argument
+// and passes it down to the growth, so a call that doesn't grow the vector doesn't touch the trace.
+// EmplaceBack and Emplace can't, as their arguments are a pack, and are recorded without one;
+// EmplaceBackAt and EmplaceAt take the site first, e.g. v.EmplaceBackAt(VectorCallSite::Current(), args...).
+// An event reads the time stamp counter on x86 and the steady clock elsewhere; the ticks are
+// converted to nanoseconds when the events are read. The events of a thread can be written in
+// the Chrome trace format, see WriteChromeTrace
+
+#ifdef VECTOR_ENABLE_TRACE
+inline constexpr bool VECTOR_TRACE_ENABLED = true;
+#else
+inline constexpr bool VECTOR_TRACE_ENABLED = false;
+#endif
+
+// the place of a call, given by the defaults of Current like std::source_location::current does
+struct VectorCallSite {
+    const char* file = nullptr;
+    unsigned line = 0;
+    const char* function = nullptr;
+
+    static constexpr VectorCallSite Current(const char* file = __builtin_FILE(), unsigned line = __builtin_LINE(),
+                                            const char* function = __builtin_FUNCTION()) noexcept {
+        return { file, line, function };
+    }
+};
+
+struct VectorGrowthEvent {
+    // file is nullptr if the call site is not known
+    VectorCallSite site;
+    size_t old_capacity = 0;
+    size_t new_capacity = 0;
+    size_t items_relocated = 0;
+    size_t item_size = 0;
+    // since the epoch of std::chrono::steady_clock
+    uint64_t start_ns = 0;
+    uint64_t duration_ns = 0;
+};
+
+// the events of one thread in the order they happened, valid until the thread records or resets the trace
+struct VectorTraceEvents {
+    const VectorGrowthEvent* events = nullptr;
+    size_t size = 0;
+    // events that didn't fit into the buffer of the thread
+    size_t dropped = 0;
+
+    const VectorGrowthEvent* begin() const noexcept {
+        return events;
+    }
+
+    const VectorGrowthEvent* end() const noexcept {
+        return events + size;
+    }
+};
+
+using VectorTraceExporter = void (*)(VectorTraceEvents events);
+
+namespace vector_detail {
+
+    inline constexpr size_t TRACE_BUFFER_EVENTS = size_t{ 1 } << 16;
+
+    inline std::atomic<VectorTraceExporter> trace_exporter{ nullptr };
+
+    inline uint64_t TraceClock() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    // the time stamp counter costs a fraction of the steady clock; it is invariant on the CPUs
+    // of the last decade, so its ticks have a fixed length
+    inline uint64_t TraceTicks() noexcept {
+#if defined(VECTOR_TRACE_TSC)
+        return __rdtsc();
+#else
+        return TraceClock();
+#endif
+    }
+
+    // the buffer is allocated by the first event, so threads that don't grow vectors pay nothing;
+    // it is not initialized, so its pages are touched only as the events fill them. The events
+    // are recorded in ticks and converted by Events(), which measures the length of a tick
+    // against the steady clock since the first event
+    struct ThreadTrace {
+        ~ThreadTrace() {
+            if (VectorTraceExporter exporter = trace_exporter.load()) {
+                exporter(Events());
+            }
+        }
+
+        // start_ns and duration_ns of event are in ticks
+        void Record(const VectorGrowthEvent& event) noexcept {
+            if (buffer == nullptr) {
+                buffer.reset(new (std::nothrow) unsigned char[TRACE_BUFFER_EVENTS * sizeof(VectorGrowthEvent)]);
+                origin_ns = TraceClock();
+                origin_ticks = TraceTicks();
+            }
+            if (buffer == nullptr || size == TRACE_BUFFER_EVENTS) {
+                ++dropped;
+                return;
+            }
+            new (buffer.get() + size * sizeof(VectorGrowthEvent)) VectorGrowthEvent(event);
+            ++size;
+        }
+
+        VectorTraceEvents Events() noexcept {
+            VectorGrowthEvent* events = std::launder(reinterpret_cast<VectorGrowthEvent*>(buffer.get()));
+            if (converted < size) {
+                const uint64_t ticks = TraceTicks() - origin_ticks;
+                const uint64_t ns = TraceClock() - origin_ns;
+                const double ns_per_tick = ticks == 0 ? 1.0 : static_cast<double>(ns) / static_cast<double>(ticks);
+                for (; converted < size; ++converted) {
+                    VectorGrowthEvent& event = events[converted];
+                    // the origin is taken when the first event ends, so that one starts before it
+                    const auto start = static_cast<double>(static_cast<int64_t>(event.start_ns - origin_ticks));
+                    event.start_ns = origin_ns + static_cast<uint64_t>(static_cast<int64_t>(start * ns_per_tick));
+                    event.duration_ns = static_cast<uint64_t>(static_cast<double>(event.duration_ns) * ns_per_tick);
+                }
+            }
+            return { events, size, dropped };
+        }
+
+        std::unique_ptr<unsigned char[]> buffer;
+        size_t size = 0;
+        size_t dropped = 0;
+        // the events before converted are in nanoseconds
+        size_t converted = 0;
+        uint64_t origin_ns = 0;
+        uint64_t origin_ticks = 0;
+    };
+
+    inline ThreadTrace& LocalTrace() noexcept {
+        thread_local ThreadTrace thread_trace;
+        return thread_trace;
+    }
+
+    // default argument of the traced methods, empty without tracing
+    struct NoCallSite {
+        static constexpr NoCallSite Current() noexcept {
+            return {};
+        }
+    };
+
+    using TraceSite = std::conditional_t<VECTOR_TRACE_ENABLED, VectorCallSite, NoCallSite>;
+
+    // measures a change of the buffer of storage made by a call from site and records it when it ends
+    // without an exception, if the capacity has changed
+    template <typename Storage>
+    class GrowthTrace {
+    public:
+        GrowthTrace([[maybe_unused]] const Storage& storage, [[maybe_unused]] size_t items,
+                    [[maybe_unused]] size_t item_size, [[maybe_unused]] const TraceSite& site) noexcept
+            : storage_(storage) {
+            if constexpr (VECTOR_TRACE_ENABLED) {
+                SetSite(site);
+                event_.old_capacity = storage.Capacity();
+                event_.items_relocated = items;
+                event_.item_size = item_size;
+                exceptions_ = std::uncaught_exceptions();
+                event_.start_ns = TraceTicks();
+            }
+        }
+
+        GrowthTrace(const GrowthTrace&) = delete;
+
+        GrowthTrace& operator=(const GrowthTrace&) = delete;
+
+        ~GrowthTrace() {
+            if constexpr (VECTOR_TRACE_ENABLED) {
+                if (std::uncaught_exceptions() > exceptions_ || storage_.Capacity() == event_.old_capacity) {
+                    return;
+                }
+                event_.duration_ns = TraceTicks() - event_.start_ns;
+                event_.new_capacity = storage_.Capacity();
+                LocalTrace().Record(event_);
+            }
+        }
+
+    private:
+        void SetSite(const VectorCallSite& site) noexcept {
+            event_.site = site;
+        }
+
+        void SetSite(NoCallSite) noexcept {
+        }
+
+        const Storage& storage_;
+        VectorGrowthEvent event_;
+        int exceptions_ = 0;
+    };
+
+    // the characters of text escaped for a JSON string
+    inline void WriteJsonChars(std::ostream& out, const char* text) {
+        for (; text != nullptr && *text != '\0'; ++text) {
+            const char c = *text;
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20) {
+                out << ' ';
+            }
+            else {
+                out << c;
+            }
+        }
+    }
+
+    inline void WriteJsonString(std::ostream& out, const char* text) {
+        out << '"';
+        WriteJsonChars(out, text);
+        out << '"';
+    }
+
+}  // namespace vector_detail
+
+// returns the events of the current thread
+inline VectorTraceEvents GetVectorTrace() noexcept {
+    return vector_detail::LocalTrace().Events();
+}
+
+inline void ResetVectorTrace() noexcept {
+    vector_detail::ThreadTrace& trace = vector_detail::LocalTrace();
+    trace.size = 0;
+    trace.dropped = 0;
+    trace.converted = 0;
+}
+
+// exporter is called with the final events of each thread that recorded some when it exits
+inline void SetVectorTraceExporter(VectorTraceExporter exporter) noexcept {
+    vector_detail::trace_exporter.store(exporter);
+}
+
+// writes the events as a JSON object of the Chrome trace event format, which chrome://tracing and
+// Perfetto open; every growth is a complete event named by its call site, so the viewers sum up
+// the time and the number of growths per site. Events of several threads go to separate files
+// or are merged by the viewer
+inline void WriteChromeTrace(std::ostream& out, VectorTraceEvents events, unsigned thread_id = 0) {
+    out << "{\"traceEvents\":[";
+    bool is_first = true;
+    for (const VectorGrowthEvent& event : events) {
+        out << (is_first ? "\n" : ",\n") << "{\"name\":";
+        is_first = false;
+        if (event.site.file == nullptr) {
+            out << "\"unknown site\"";
+        }
+        else {
+            out << '"';
+            vector_detail::WriteJsonChars(out, event.site.file);
+            out << ':' << event.site.line << '"';
+        }
+        out << ",\"cat\":\"vector\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread_id
+            << ",\"ts\":" << event.start_ns / 1000 << '.' << event.start_ns / 100 % 10
+            << ",\"dur\":" << event.duration_ns / 1000 << '.' << event.duration_ns / 100 % 10
+            << ",\"args\":{\"function\":";
+        vector_detail::WriteJsonString(out, event.site.function);
+        out << ",\"old_capacity\":" << event.old_capacity << ",\"new_capacity\":" << event.new_capacity
+            << ",\"items_relocated\":" << event.items_relocated
+            << ",\"bytes\":" << event.new_capacity * event.item_size << "}}";
+    }
+    out << "\n],\"otherData\":{\"dropped_events\":" << events.dropped << "}}\n";
+}